@@ -833,7 +833,14 @@ void AM_Ticker (void)
 //
 void AM_clearFB(int color)
 {
+#ifdef FEATURE_COLUMN_MAJOR
+    int x;
+
+    for (x = 0; x < f_w; x++)
+        memset(fb + SCREENOFS(x, 0), color, f_h);
+#else
     memset(fb, color, f_w*f_h);
+#endif
 }
 
 
@@ -1007,7 +1014,7 @@ AM_drawFline
 	return;
     }
 
-#define PUTDOT(xx,yy,cc) fb[(yy)*f_w+(xx)]=(cc)
+#define PUTDOT(xx,yy,cc) fb[SCREENOFS(xx,yy)]=(cc)
 
     dx = fl->b.x - fl->a.x;
     ax = 2 * (dx<0 ? -dx : dx);
@@ -1331,7 +1338,7 @@ void AM_drawMarks(void)
 
 void AM_drawCrosshair(int color)
 {
-    fb[(f_w*(f_h+1))/2] = color; // single point for now
+    fb[SCREENOFS(f_w/2, (f_h+1)/2)] = color; // single point for now
 
 }
 
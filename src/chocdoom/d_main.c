@@ -68,8 +68,10 @@
 #include "net_dedicated.h"
 #include "net_query.h"
 
+#include "p_local.h"
 #include "p_setup.h"
 #include "r_local.h"
+#include "r_colcache.h"
 #include "statdump.h"
 
 
@@ -367,7 +369,19 @@ void D_BindVariables(void)
     M_BindVariable("snd_channels",           &snd_channels);
     M_BindVariable("vanilla_savegame_limit", &vanilla_savegame_limit);
     M_BindVariable("vanilla_demo_limit",     &vanilla_demo_limit);
+    M_BindVariable("vanilla_render_limits",  &vanilla_render_limits);
+    M_BindVariable("render_arena_size",      &render_arena_size);
+    M_BindVariable("column_cache_size",      &column_cache_size);
+    M_BindVariable("frame_budget",           &frame_budget);
+    M_BindVariable("frame_budget_hysteresis", &frame_budget_hysteresis);
+    M_BindVariable("zone_stats_tics",        &zone_stats_tics);
+    M_BindVariable("zone_trace",             &zone_trace);
     M_BindVariable("show_endoom",            &show_endoom);
+    M_BindVariable("draw_column_check",      &draw_column_check);
+    M_BindVariable("draw_span_check",        &draw_span_check);
+    M_BindVariable("sprite_sort_check",      &sprite_sort_check);
+    M_BindVariable("fixed_div_check",        &fixed_div_check);
+    M_BindVariable("intercept_check",        &intercept_check);
 
     // Multiplayer chat macros
 
@@ -408,6 +422,8 @@ boolean D_GrabMouseCallback(void)
 //
 void D_DoomLoop (void)
 {
+    int zonestatstic = 0;
+
     if (bfgedition &&
         (demorecording || (gameaction == ga_playdemo) || netgame))
     {
@@ -447,6 +463,13 @@ void D_DoomLoop (void)
 
 		TryRunTics (); // will run at least one tic
 
+		// stream the zone stats over the debug UART
+		if (zone_stats_tics > 0 && gametic >= zonestatstic)
+		{
+			Z_PrintStats ();
+			zonestatstic = gametic + zone_stats_tics;
+		}
+
 		S_UpdateSounds (players[consoleplayer].mo);// move positional sounds
 
 		// Update display, next frame, with current state.
@@ -1757,6 +1780,9 @@ void D_DoomMain (void)
     DEH_printf("M_Init: Init miscellaneous info.\n");
     M_Init ();
 
+    if (fixed_div_check)
+        M_CheckFixedDiv ();
+
     DEH_printf("R_Init: Init DOOM refresh daemon - ");
     R_Init ();
 
@@ -35,6 +35,11 @@
 
 #undef FEATURE_SOUND
 
+// Stores the screen buffers column-major, so that the column drawers
+// write sequential bytes and each Doom column is one contiguous LCD line
+
+#undef FEATURE_COLUMN_MAJOR
+
 #endif /* #ifndef DOOM_FEATURES_H */
 
 
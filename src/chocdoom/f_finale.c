@@ -239,7 +239,14 @@ void F_TextWrite (void)
     // erase the entire screen to a tiled background
     src = W_CacheLumpName ( finaleflat , PU_CACHE);
     dest = I_VideoBuffer;
-	
+
+#ifdef FEATURE_COLUMN_MAJOR
+    for (x=0 ; x<SCREENWIDTH ; x++)
+    {
+	for (y=0 ; y<SCREENHEIGHT ; y++)
+	    *dest++ = src[((y&63)<<6) + (x&63)];
+    }
+#else
     for (y=0 ; y<SCREENHEIGHT ; y++)
     {
 	for (x=0 ; x<SCREENWIDTH/64 ; x++)
@@ -253,6 +260,7 @@ void F_TextWrite (void)
 	    dest += (SCREENWIDTH&63);
 	}
     }
+#endif
 
     V_MarkRect (0, 0, SCREENWIDTH, SCREENHEIGHT);
     
@@ -581,19 +589,19 @@ F_DrawPatchCol
     int		count;
 	
     column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
-    desttop = I_VideoBuffer + x;
+    desttop = I_VideoBuffer + SCREENOFS(x, 0);
 
     // step through the posts in a column
     while (column->topdelta != 0xff )
     {
 	source = (byte *)column + 3;
-	dest = desttop + column->topdelta*SCREENWIDTH;
+	dest = desttop + column->topdelta*SCREENYSTEP;
 	count = column->length;
 		
 	while (count--)
 	{
 	    *dest = *source++;
-	    dest += SCREENWIDTH;
+	    dest += SCREENYSTEP;
 	}
 	column = (column_t *)(  (byte *)column + column->length + 4 );
     }
@@ -18,7 +18,6 @@
 
 #include <string.h>
 
-#include "z_zone.h"
 #include "i_video.h"
 #include "v_video.h"
 #include "m_random.h"
@@ -30,104 +29,18 @@
 //
 //                       SCREEN WIPE PACKAGE
 //
+// The start and end screens are kept converted for the LCD in spare
+// buffers and the melt is drawn from them into the LCD frame directly,
+// so a wipe neither allocates zone memory nor converts I_VideoBuffer.
+// The color transform works on the 8-bit screen and is not available.
+//
 
 // when zero, stop the wipe
 static boolean	go = 0;
 
-static byte*	wipe_scr_start;
-static byte*	wipe_scr_end;
-static byte*	wipe_scr;
-
-
-void
-wipe_shittyColMajorXform
-( short*	array,
-  int		width,
-  int		height )
-{
-    int		x;
-    int		y;
-    short*	dest;
-
-    dest = (short*) Z_Malloc(width*height*2, PU_STATIC, 0);
-
-    for(y=0;y<height;y++)
-	for(x=0;x<width;x++)
-	    dest[x*height+y] = array[y*width+x];
-
-    memcpy(array, dest, width*height*2);
-
-    Z_Free(dest);
-
-}
-
-int
-wipe_initColorXForm
-( int	width,
-  int	height,
-  int	ticks )
-{
-    memcpy(wipe_scr, wipe_scr_start, width*height);
-    return 0;
-}
-
-int
-wipe_doColorXForm
-( int	width,
-  int	height,
-  int	ticks )
-{
-    boolean	changed;
-    byte*	w;
-    byte*	e;
-    int		newval;
-
-    changed = false;
-    w = wipe_scr;
-    e = wipe_scr_end;
-    
-    while (w!=wipe_scr+width*height)
-    {
-	if (*w != *e)
-	{
-	    if (*w > *e)
-	    {
-		newval = *w - ticks;
-		if (newval < *e)
-		    *w = *e;
-		else
-		    *w = newval;
-		changed = true;
-	    }
-	    else if (*w < *e)
-	    {
-		newval = *w + ticks;
-		if (newval > *e)
-		    *w = *e;
-		else
-		    *w = newval;
-		changed = true;
-	    }
-	}
-	w++;
-	e++;
-    }
-
-    return !changed;
+// column positions of the melt
+static int	y[SCREENWIDTH];
 
-}
-
-int
-wipe_exitColorXForm
-( int	width,
-  int	height,
-  int	ticks )
-{
-    return 0;
-}
-
-
-static int*	y;
 
 int
 wipe_initMelt
@@ -137,17 +50,8 @@ wipe_initMelt
 {
     int i, r;
     
-    // copy start screen to main screen
-    memcpy(wipe_scr, wipe_scr_start, width*height);
-    
-    // makes this wipe faster (in theory)
-    // to have stuff in column-major format
-    wipe_shittyColMajorXform((short*)wipe_scr_start, width/2, height);
-    wipe_shittyColMajorXform((short*)wipe_scr_end, width/2, height);
-    
     // setup initial column positions
     // (y<0 => not ready to scroll yet)
-    y = (int *) Z_Malloc(width*sizeof(int), PU_STATIC, 0);
     y[0] = -(M_Random()%16);
     for (i=1;i<width;i++)
     {
@@ -167,12 +71,7 @@ wipe_doMelt
   int	ticks )
 {
     int		i;
-    int		j;
     int		dy;
-    int		idx;
-    
-    short*	s;
-    short*	d;
     boolean	done = true;
 
     width/=2;
@@ -189,28 +88,15 @@ wipe_doMelt
 	    {
 		dy = (y[i] < 16) ? y[i]+1 : 8;
 		if (y[i]+dy >= height) dy = height - y[i];
-		s = &((short *)wipe_scr_end)[i*height+y[i]];
-		d = &((short *)wipe_scr)[y[i]*width+i];
-		idx = 0;
-		for (j=dy;j;j--)
-		{
-		    d[idx] = *(s++);
-		    idx += width;
-		}
 		y[i] += dy;
-		s = &((short *)wipe_scr_start)[i*height];
-		d = &((short *)wipe_scr)[y[i]*width+i];
-		idx = 0;
-		for (j=height-y[i];j;j--)
-		{
-		    d[idx] = *(s++);
-		    idx += width;
-		}
 		done = false;
 	    }
 	}
     }
 
+    // move the column pairs of the start screen down to the new positions
+    I_DrawMelt(y);
+
     return done;
 
 }
@@ -221,9 +107,6 @@ wipe_exitMelt
   int	height,
   int	ticks )
 {
-    Z_Free(y);
-    Z_Free(wipe_scr_start);
-    Z_Free(wipe_scr_end);
     return 0;
 }
 
@@ -234,8 +117,7 @@ wipe_StartScreen
   int	width,
   int	height )
 {
-    wipe_scr_start = Z_Malloc(SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
-    I_ReadScreen(wipe_scr_start);
+    I_ReadWipeScreen(0);
     return 0;
 }
 
@@ -246,9 +128,8 @@ wipe_EndScreen
   int	width,
   int	height )
 {
-    wipe_scr_end = Z_Malloc(SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
-    I_ReadScreen(wipe_scr_end);
-    V_DrawBlock(x, y, width, height, wipe_scr_start); // restore start scr.
+    // the screen keeps the end screen, the melt is drawn from the copies
+    I_ReadWipeScreen(1);
     return 0;
 }
 
@@ -264,7 +145,6 @@ wipe_ScreenWipe
     int rc;
     static int (*wipes[])(int, int, int) =
     {
-	wipe_initColorXForm, wipe_doColorXForm, wipe_exitColorXForm,
 	wipe_initMelt, wipe_doMelt, wipe_exitMelt
     };
 
@@ -272,21 +152,17 @@ wipe_ScreenWipe
     if (!go)
     {
 	go = 1;
-	// wipe_scr = (byte *) Z_Malloc(width*height, PU_STATIC, 0); // DEBUG
-	wipe_scr = I_VideoBuffer;
-	(*wipes[wipeno*3])(width, height, ticks);
+	(*wipes[0])(width, height, ticks);
     }
 
     // do a piece of wipe-in
-    V_MarkRect(0, 0, width, height);
-    rc = (*wipes[wipeno*3+1])(width, height, ticks);
-    //  V_DrawBlock(x, y, 0, width, height, wipe_scr); // DEBUG
+    rc = (*wipes[1])(width, height, ticks);
 
     // final stuff
     if (rc)
     {
 	go = 0;
-	(*wipes[wipeno*3+2])(width, height, ticks);
+	(*wipes[2])(width, height, ticks);
     }
 
     return !go;
@@ -65,6 +65,7 @@
 #include "sounds.h"
 
 // SKY handling - still the wrong place.
+#include "r_colcache.h"
 #include "r_data.h"
 #include "r_sky.h"
 
@@ -1323,6 +1324,9 @@ void G_DoCompleted (void)
     int             i; 
 	 
     gameaction = ga_nothing; 
+
+    printf ("%u BSP nodes visited, %u back spaces rejected\n",
+            bsp_nodes_visited, bsp_bbox_rejects);
  
     for (i=0 ; i<MAXPLAYERS ; i++) 
 	if (playeringame[i]) 
@@ -2198,6 +2202,30 @@ boolean G_CheckDemoStatus (void)
         timingdemo = false;
         demoplayback = false;
 
+        I_PrintBlitStats ();
+
+        printf ("%u visplane lookups, %u collisions, "
+                "%u visplanes per frame, %u peak\n",
+                visplane_lookups, visplane_collisions,
+                visplane_frames ? visplane_total / visplane_frames : 0,
+                visplane_peak);
+
+        printf ("%u BSP nodes visited, %u back spaces rejected\n",
+                bsp_nodes_visited, bsp_bbox_rejects);
+
+        printf ("%u lit column hits, %u misses (%u%%)\n",
+                column_cache_hits, column_cache_misses,
+                column_cache_hits + column_cache_misses ?
+                    (unsigned) ((uint64_t) column_cache_hits * 100
+                        / (column_cache_hits + column_cache_misses)) : 0);
+
+        printf ("%u sight checks from the cache, %u BSP walks\n",
+                sight_cache_hits, sight_cache_misses);
+
+        R_PrintArenaStats ();
+        Z_PrintSlabStats ();
+        Z_PrintStats ();
+
 	I_Error ("timed %i gametics in %i realtics (%f fps)",
                  gametic, realtics, fps);
     } 
@@ -382,6 +382,16 @@ static void I_InitStretchTables(byte *palette)
     puts("");
 }
 
+// Get the lookup tables for aspect ratio correcting scale up, to blend
+// palette indexes outside of the I_Stretch functions.
+
+byte **I_GetStretchTables(byte *palette)
+{
+    I_InitStretchTables(palette);
+
+    return stretch_tables;
+}
+
 // Create 50%/50% table for 800x600 squash mode
 
 static void I_InitSquashTable(byte *palette)
@@ -24,6 +24,7 @@
 
 void I_InitScale(byte *_src_buffer, byte *_dest_buffer, int _dest_pitch);
 void I_ResetScaleTables(byte *palette);
+byte **I_GetStretchTables(byte *palette);
 
 // Scaled modes (direct multiples of 320x200)
 
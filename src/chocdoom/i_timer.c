@@ -25,6 +25,10 @@
 
 #include "main.h"
 
+#ifndef ORIGCODE
+#include "stm32f4xx.h"
+#endif
+
 #ifdef ORIGCODE
 
 //
@@ -77,6 +81,16 @@ void I_WaitVBL(int count)
 }
 
 
+//
+// I_GetCycles
+// returns a free-running counter for profiling; SDL only has ms
+//
+
+unsigned int I_GetCycles(void)
+{
+    return SDL_GetTicks();
+}
+
 void I_InitTimer(void)
 {
     // initialize timer
@@ -136,9 +150,23 @@ void I_WaitVBL(int count)
 }
 
 
+//
+// I_GetCycles
+// returns the free-running CPU cycle counter (168 MHz), for profiling
+//
+
+unsigned int I_GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
 void I_InitTimer(void)
 {
     // initialize timer
+
+    // enable the DWT cycle counter used by I_GetCycles
+
+    cycle_counter_init ();
 }
 
 #endif
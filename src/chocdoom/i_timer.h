@@ -38,5 +38,9 @@ void I_InitTimer(void);
 // Wait for vertical retrace or pause a bit.
 void I_WaitVBL(int count);
 
+// Free-running cycle counter, used to profile hot paths.
+
+unsigned int I_GetCycles(void);
+
 #endif
 
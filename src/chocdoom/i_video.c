@@ -32,9 +32,15 @@ rcsid[] = "$Id: i_x.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 #include "d_main.h"
 #include "i_video.h"
 #include "z_zone.h"
+#include "w_wad.h"
+#include "deh_str.h"
 
 #include "tables.h"
 #include "doomkeys.h"
+#include "i_timer.h"
+#include "m_bbox.h"
+#include "m_config.h"
+#include "i_scale.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -43,6 +49,7 @@ rcsid[] = "$Id: i_x.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 #include "images.h"
 #include "touch.h"
 #include "button.h"
+#include "debug.h"
 
 // The screen buffer; this is modified to draw things to the screen
 
@@ -93,6 +100,115 @@ typedef struct
 
 static uint16_t rgb565_palette[256];
 
+// Palette as loaded into the LCD's color look-up table, 0x00RRGGBB
+
+static uint32_t clut_palette[256];
+
+// Weights of the steps of I_Stretch1x, in fifths, as in i_scale.c
+
+#define STRETCH_20 1
+#define STRETCH_40 2
+#define STRETCH_100 5
+
+// i_scale.c's tables for blending palette indexes, used by both
+// stretched blits
+
+static byte **stretch_tables;
+
+// LCD column of the first Doom pixel in every LCD line, without and
+// with aspect ratio correction
+
+#define SCREEN_LCD_X (GFX_MAX_WIDTH - SCREENHEIGHT)
+
+static int screen_lcd_x = SCREEN_LCD_X;
+
+// Blit engines converting I_VideoBuffer to the rotated RGB565 LCD layer
+
+typedef enum
+{
+	BLIT_REFERENCE,		// one palette lookup and one column-stride write per pixel
+	BLIT_TILED,			// 4x2 tiles, two pixels per 32-bit write along each LCD line
+						// (linear per-column conversion with FEATURE_COLUMN_MAJOR)
+	NUM_BLITS
+} blit_t;
+
+// Blit engine to use, selected once in I_InitGraphics
+
+int video_blit = BLIT_TILED;
+
+// If non-zero, check the selected blit engine against the reference
+// engine at startup and print the cycles per frame of both
+
+int video_blit_check = 0;
+
+// If non-zero, the LCD shows I_VideoBuffer through an 8-bit indexed
+// layer and its color look-up table instead of an RGB565 layer
+
+int video_clut = 0;
+
+// If non-zero, the 200 screen lines are stretched to the full 240 LCD
+// columns, covering the touch keys
+
+int aspect_ratio_correct = 0;
+
+// Cycles spent in the blit of the last frame
+
+unsigned int blit_cycles;
+
+// Pixels left untouched in the back layer by the last frame's blit
+
+unsigned int blit_skipped;
+
+// Frames shown, and frames neither converted nor shown because they
+// equal the frame shown last
+
+unsigned int blit_frames;
+unsigned int blit_frames_unchanged;
+
+// blit_cycles and blit_skipped summed over all frames since startup
+
+static uint64_t blit_cycles_total;
+static uint64_t blit_skipped_total;
+
+// Blit engine, converting the screen area x1 <= x < x2, y1 <= y < y2
+
+typedef void (*blit_func_t) (int x1, int y1, int x2, int y2);
+
+static blit_func_t blit_func;
+
+// dirtyboxes of the previous frames, most recent first: the buffer drawn
+// to still shows the frame lcd_frame_buffers frames back, so the areas
+// changed by any frame since then have to be converted
+
+static int last_dirtybox[LCD_FRAME_BUFFERS - 1][4];
+
+// Number of coming frames that have to be converted completely, e.g.
+// after a palette change, which affects all buffers
+
+static int full_blits;
+
+// Set by I_DrawMelt when it has drawn the next frame
+
+static boolean melt_drawn;
+
+// Set by I_SetPalette until the next frame is shown
+
+static boolean palette_changed;
+
+// Lines of I_VideoBuffer in memory: rows, or columns if column-major
+
+#ifdef FEATURE_COLUMN_MAJOR
+#define SCREENLINES SCREENWIDTH
+#else
+#define SCREENLINES SCREENHEIGHT
+#endif
+
+#define SCREENLINELENGTH (SCREENWIDTH * SCREENHEIGHT / SCREENLINES)
+
+// Signature of every line as it was last converted
+
+static uint32_t line_signatures[SCREENLINES];
+
 // Last touch state
 
 static touch_state_t last_touch_state;
@@ -105,6 +221,514 @@ static bool last_button_state;
 
 static bool run;
 
+//
+// Reference blit: walks I_VideoBuffer row by row, so every LCD write
+// lands one LCD line (GFX_MAX_WIDTH pixels) away from the previous one.
+//
+static void I_BlitReference (int x1, int y1, int x2, int y2)
+{
+	int x, y;
+	byte index;
+
+	for (y = y1; y < y2; y++)
+	{
+		for (x = x1; x < x2; x++)
+		{
+			index = I_VideoBuffer[SCREENOFS(x, y)];
+
+			((uint16_t*)lcd_frame_buffer)[x * GFX_MAX_WIDTH + (GFX_MAX_WIDTH - y - 1)] = rgb565_palette[index];
+		}
+	}
+}
+
+#ifdef FEATURE_COLUMN_MAJOR
+
+//
+// Column blit: Doom column x is LCD line x, stored bottom to top, and
+// with a column-major I_VideoBuffer it also is contiguous in memory.
+// Every line is a linear palette conversion of one source column read
+// backwards, one 32-bit word of four pixels at a time, so y1 and y2
+// are widened to multiples of four.
+//
+static void I_BlitTiled (int x1, int y1, int x2, int y2)
+{
+	const uint32_t *src;
+	uint32_t *line;
+	uint32_t quad;
+	int x, y;
+
+	y1 &= ~3;
+	y2 = (y2 + 3) & ~3;
+
+	for (x = x1; x < x2; x++)
+	{
+		src = (const uint32_t*)(I_VideoBuffer + SCREENOFS(x, y2));
+		line = (uint32_t*)((uint16_t*)lcd_frame_buffer + x * GFX_MAX_WIDTH + GFX_MAX_WIDTH - y2);
+
+		for (y = y1; y < y2; y += 4)
+		{
+			// the last byte holds the highest y, which comes first in the line
+
+			quad = *--src;
+
+			*line++ = rgb565_palette[quad >> 24] | (rgb565_palette[(quad >> 16) & 0xFF] << 16);
+			*line++ = rgb565_palette[(quad >> 8) & 0xFF] | (rgb565_palette[quad & 0xFF] << 16);
+		}
+	}
+}
+
+#else
+
+//
+// Tiled blit: Doom column x is LCD line x, stored bottom to top.
+// Four Doom columns are handled at once, reading one 32-bit word from
+// two source rows per step and writing two packed pixels to each of
+// the four LCD lines, so all writes are sequential 32-bit stores.
+// The area is widened to whole tiles.
+//
+static void I_BlitTiled (int x1, int y1, int x2, int y2)
+{
+	const byte *src;
+	uint32_t *line0, *line1, *line2, *line3;
+	uint32_t lo, hi;
+	int x, y;
+
+	x1 &= ~3;
+	x2 = (x2 + 3) & ~3;
+	y1 &= ~1;
+	y2 = (y2 + 1) & ~1;
+
+	for (x = x1; x < x2; x += 4)
+	{
+		// pixel (x, y2 - 1) is the first Doom pixel to write to LCD line x
+
+		line0 = (uint32_t*)((uint16_t*)lcd_frame_buffer + x * GFX_MAX_WIDTH + GFX_MAX_WIDTH - y2);
+		line1 = line0 + GFX_MAX_WIDTH / 2;
+		line2 = line1 + GFX_MAX_WIDTH / 2;
+		line3 = line2 + GFX_MAX_WIDTH / 2;
+
+		src = I_VideoBuffer + (y2 - 1) * SCREENWIDTH + x;
+
+		for (y = y2 - 1; y > y1; y -= 2)
+		{
+			// lower address holds the lower row, i.e. the higher y
+
+			lo = *(const uint32_t*)src;
+			hi = *(const uint32_t*)(src - SCREENWIDTH);
+			src -= 2 * SCREENWIDTH;
+
+			*line0++ = rgb565_palette[lo & 0xFF] | (rgb565_palette[hi & 0xFF] << 16);
+			*line1++ = rgb565_palette[(lo >> 8) & 0xFF] | (rgb565_palette[(hi >> 8) & 0xFF] << 16);
+			*line2++ = rgb565_palette[(lo >> 16) & 0xFF] | (rgb565_palette[(hi >> 16) & 0xFF] << 16);
+			*line3++ = rgb565_palette[lo >> 24] | (rgb565_palette[hi >> 24] << 16);
+		}
+	}
+}
+
+#endif
+
+static const blit_func_t blit_funcs[NUM_BLITS] =
+{
+	I_BlitReference,
+	I_BlitTiled
+};
+
+#ifdef FEATURE_COLUMN_MAJOR
+
+//
+// Indexed blit: every LCD line is one source column read backwards,
+// copied one 32-bit word at a time with the byte order reversed.
+// y1 and y2 are widened to multiples of four.
+//
+static void I_BlitIndexed (int x1, int y1, int x2, int y2)
+{
+	const uint32_t *src;
+	uint32_t *line;
+	int x, y;
+
+	y1 &= ~3;
+	y2 = (y2 + 3) & ~3;
+
+	for (x = x1; x < x2; x++)
+	{
+		src = (const uint32_t*)(I_VideoBuffer + SCREENOFS(x, y2));
+		line = (uint32_t*)((byte*)lcd_frame_buffer + x * SCREENHEIGHT + SCREENHEIGHT - y2);
+
+		for (y = y1; y < y2; y += 4)
+		{
+			*line++ = __builtin_bswap32 (*--src);
+		}
+	}
+}
+
+#else
+
+//
+// Indexed blit: the rotation of I_BlitTiled without the palette lookup.
+// Tiles of 4x4 pixels are read as four 32-bit words from four source
+// rows and written transposed as one 32-bit word to each of four LCD
+// lines. The area is widened to whole tiles.
+//
+static void I_BlitIndexed (int x1, int y1, int x2, int y2)
+{
+	const byte *src;
+	uint32_t *line0, *line1, *line2, *line3;
+	uint32_t r0, r1, r2, r3;
+	int x, y;
+
+	x1 &= ~3;
+	x2 = (x2 + 3) & ~3;
+	y1 &= ~3;
+	y2 = (y2 + 3) & ~3;
+
+	for (x = x1; x < x2; x += 4)
+	{
+		line0 = (uint32_t*)((byte*)lcd_frame_buffer + x * SCREENHEIGHT + SCREENHEIGHT - y2);
+		line1 = line0 + SCREENHEIGHT / 4;
+		line2 = line1 + SCREENHEIGHT / 4;
+		line3 = line2 + SCREENHEIGHT / 4;
+
+		src = I_VideoBuffer + (y2 - 1) * SCREENWIDTH + x;
+
+		for (y = y2 - 1; y > y1; y -= 4)
+		{
+			// r0 is the highest y, which comes first in the line
+
+			r0 = *(const uint32_t*)src;
+			r1 = *(const uint32_t*)(src - SCREENWIDTH);
+			r2 = *(const uint32_t*)(src - 2 * SCREENWIDTH);
+			r3 = *(const uint32_t*)(src - 3 * SCREENWIDTH);
+			src -= 4 * SCREENWIDTH;
+
+			*line0++ = (r0 & 0xFF) | ((r1 & 0xFF) << 8) | ((r2 & 0xFF) << 16) | (r3 << 24);
+			*line1++ = ((r0 >> 8) & 0xFF) | (r1 & 0xFF00) | ((r2 & 0xFF00) << 8) | ((r3 & 0xFF00) << 16);
+			*line2++ = ((r0 >> 16) & 0xFF) | ((r1 >> 8) & 0xFF00) | (r2 & 0xFF0000) | ((r3 & 0xFF0000) << 8);
+			*line3++ = (r0 >> 24) | ((r1 >> 16) & 0xFF00) | ((r2 >> 8) & 0xFF0000) | (r3 & 0xFF000000);
+		}
+	}
+}
+
+#endif
+
+//
+// Aspect ratio correction: like I_Stretch1x, every five screen lines
+// become six LCD columns, the inner four blended from two neighbours.
+// The blended palette index is looked up in i_scale.c's stretch tables,
+// so a blended pixel costs only one lookup more than a plain one.
+//
+
+// Color of the stretched pixel (x, y), 0 <= y < SCREENHEIGHT_4_3
+
+static uint16_t I_StretchedPixel (int x, int y)
+{
+	static const int rows[6][2] = { { 0, 0 }, { 0, 1 }, { 1, 2 }, { 3, 2 }, { 4, 3 }, { 4, 4 } };
+	static const int weights[6] = { STRETCH_100, STRETCH_20, STRETCH_40, STRETCH_40, STRETCH_20, STRETCH_100 };
+	const byte *src;
+	byte a, b;
+	int step;
+
+	src = I_VideoBuffer + SCREENOFS(x, y / 6 * 5);
+	step = y % 6;
+
+	a = src[rows[step][0] * SCREENYSTEP];
+	b = src[rows[step][1] * SCREENYSTEP];
+
+	if (weights[step] != STRETCH_100)
+	{
+		a = stretch_tables[weights[step] == STRETCH_40][a * 256 + b];
+	}
+
+	return rgb565_palette[a];
+}
+
+//
+// Reference stretched blit: one stretched pixel per LCD write, like
+// I_BlitReference.
+//
+static void I_BlitStretchReference (int x1, int y1, int x2, int y2)
+{
+	int x, y;
+
+	for (y = y1 / 5 * 6; y < (y2 + 4) / 5 * 6; y++)
+	{
+		for (x = x1; x < x2; x++)
+		{
+			((uint16_t*)lcd_frame_buffer)[x * GFX_MAX_WIDTH + (GFX_MAX_WIDTH - y - 1)] = I_StretchedPixel (x, y);
+		}
+	}
+}
+
+// Write the six LCD pixels of the source pixels p0 (lowest y) to p4,
+// highest y first
+
+static inline void I_StretchGroup (uint32_t *line, byte p0, byte p1, byte p2, byte p3, byte p4)
+{
+	line[0] = rgb565_palette[p4] | (rgb565_palette[stretch_tables[0][p4 * 256 + p3]] << 16);
+	line[1] = rgb565_palette[stretch_tables[1][p3 * 256 + p2]] | (rgb565_palette[stretch_tables[1][p1 * 256 + p2]] << 16);
+	line[2] = rgb565_palette[stretch_tables[0][p0 * 256 + p1]] | (rgb565_palette[p0] << 16);
+}
+
+// Indexed counterpart of I_StretchGroup
+
+static inline void I_StretchIndexedGroup (uint16_t *line, byte p0, byte p1, byte p2, byte p3, byte p4)
+{
+	line[0] = p4 | (stretch_tables[0][p4 * 256 + p3] << 8);
+	line[1] = stretch_tables[1][p3 * 256 + p2] | (stretch_tables[1][p1 * 256 + p2] << 8);
+	line[2] = stretch_tables[0][p0 * 256 + p1] | (p0 << 8);
+}
+
+#ifdef FEATURE_COLUMN_MAJOR
+
+//
+// Stretched column blit: every LCD line is one source column read
+// backwards in groups of five pixels. y1 and y2 are widened to whole
+// groups.
+//
+static void I_BlitStretched (int x1, int y1, int x2, int y2)
+{
+	const byte *src;
+	uint32_t *line;
+	int x, y;
+
+	y1 = y1 / 5 * 5;
+	y2 = (y2 + 4) / 5 * 5;
+
+	for (x = x1; x < x2; x++)
+	{
+		src = I_VideoBuffer + SCREENOFS(x, y2 - 5);
+		line = (uint32_t*)((uint16_t*)lcd_frame_buffer + x * GFX_MAX_WIDTH + GFX_MAX_WIDTH - y2 / 5 * 6);
+
+		for (y = y2; y > y1; y -= 5)
+		{
+			I_StretchGroup (line, src[0], src[1], src[2], src[3], src[4]);
+			line += 3;
+			src -= 5;
+		}
+	}
+}
+
+static void I_BlitStretchedIndexed (int x1, int y1, int x2, int y2)
+{
+	const byte *src;
+	uint16_t *line;
+	int x, y;
+
+	y1 = y1 / 5 * 5;
+	y2 = (y2 + 4) / 5 * 5;
+
+	for (x = x1; x < x2; x++)
+	{
+		src = I_VideoBuffer + SCREENOFS(x, y2 - 5);
+		line = (uint16_t*)((byte*)lcd_frame_buffer + x * GFX_MAX_WIDTH + GFX_MAX_WIDTH - y2 / 5 * 6);
+
+		for (y = y2; y > y1; y -= 5)
+		{
+			I_StretchIndexedGroup (line, src[0], src[1], src[2], src[3], src[4]);
+			line += 3;
+			src -= 5;
+		}
+	}
+}
+
+#else
+
+//
+// Stretched tiled blit: four Doom columns at once, reading one 32-bit
+// word from each of the five source rows of a group per step. The area
+// is widened to whole tiles and groups.
+//
+static void I_BlitStretched (int x1, int y1, int x2, int y2)
+{
+	const byte *src;
+	uint32_t *line;
+	uint32_t r0, r1, r2, r3, r4;
+	int x, y;
+
+	x1 &= ~3;
+	x2 = (x2 + 3) & ~3;
+	y1 = y1 / 5 * 5;
+	y2 = (y2 + 4) / 5 * 5;
+
+	for (x = x1; x < x2; x += 4)
+	{
+		src = I_VideoBuffer + (y2 - 5) * SCREENWIDTH + x;
+		line = (uint32_t*)((uint16_t*)lcd_frame_buffer + x * GFX_MAX_WIDTH + GFX_MAX_WIDTH - y2 / 5 * 6);
+
+		for (y = y2; y > y1; y -= 5)
+		{
+			r0 = *(const uint32_t*)src;
+			r1 = *(const uint32_t*)(src + SCREENWIDTH);
+			r2 = *(const uint32_t*)(src + 2 * SCREENWIDTH);
+			r3 = *(const uint32_t*)(src + 3 * SCREENWIDTH);
+			r4 = *(const uint32_t*)(src + 4 * SCREENWIDTH);
+			src -= 5 * SCREENWIDTH;
+
+			I_StretchGroup (line, r0, r1, r2, r3, r4);
+			I_StretchGroup (line + GFX_MAX_WIDTH / 2, r0 >> 8, r1 >> 8, r2 >> 8, r3 >> 8, r4 >> 8);
+			I_StretchGroup (line + GFX_MAX_WIDTH, r0 >> 16, r1 >> 16, r2 >> 16, r3 >> 16, r4 >> 16);
+			I_StretchGroup (line + 3 * GFX_MAX_WIDTH / 2, r0 >> 24, r1 >> 24, r2 >> 24, r3 >> 24, r4 >> 24);
+			line += 3;
+		}
+	}
+}
+
+static void I_BlitStretchedIndexed (int x1, int y1, int x2, int y2)
+{
+	const byte *src;
+	uint16_t *line;
+	uint32_t r0, r1, r2, r3, r4;
+	int x, y;
+
+	x1 &= ~3;
+	x2 = (x2 + 3) & ~3;
+	y1 = y1 / 5 * 5;
+	y2 = (y2 + 4) / 5 * 5;
+
+	for (x = x1; x < x2; x += 4)
+	{
+		src = I_VideoBuffer + (y2 - 5) * SCREENWIDTH + x;
+		line = (uint16_t*)((byte*)lcd_frame_buffer + x * GFX_MAX_WIDTH + GFX_MAX_WIDTH - y2 / 5 * 6);
+
+		for (y = y2; y > y1; y -= 5)
+		{
+			r0 = *(const uint32_t*)src;
+			r1 = *(const uint32_t*)(src + SCREENWIDTH);
+			r2 = *(const uint32_t*)(src + 2 * SCREENWIDTH);
+			r3 = *(const uint32_t*)(src + 3 * SCREENWIDTH);
+			r4 = *(const uint32_t*)(src + 4 * SCREENWIDTH);
+			src -= 5 * SCREENWIDTH;
+
+			I_StretchIndexedGroup (line, r0, r1, r2, r3, r4);
+			I_StretchIndexedGroup (line + GFX_MAX_WIDTH / 2, r0 >> 8, r1 >> 8, r2 >> 8, r3 >> 8, r4 >> 8);
+			I_StretchIndexedGroup (line + GFX_MAX_WIDTH, r0 >> 16, r1 >> 16, r2 >> 16, r3 >> 16, r4 >> 16);
+			I_StretchIndexedGroup (line + 3 * GFX_MAX_WIDTH / 2, r0 >> 24, r1 >> 24, r2 >> 24, r3 >> 24, r4 >> 24);
+			line += 3;
+		}
+	}
+}
+
+#endif
+
+//
+// Model of the LTDC's indexed scanout: the color the LCD shows for
+// pixel i of a full-screen RGB565 layer if Doom's area is scanned out
+// from the indexed buffer fb through clut_palette, reduced to RGB565.
+//
+static uint16_t I_ClutPixel (const byte *fb, int i)
+{
+	uint32_t color;
+
+	color = clut_palette[fb[(i / GFX_MAX_WIDTH) * (GFX_MAX_WIDTH - screen_lcd_x) + i % GFX_MAX_WIDTH - screen_lcd_x]];
+
+	return GFX_RGB565((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+}
+
+//
+// Run the reference and the selected blit engine on a test pattern,
+// compare both layers and report the cycles each engine needs.
+// The indexed engines write to a scratch buffer, which is compared
+// through the model of the CLUT. A stretched engine is checked against
+// the stretched reference and also timed against the unstretched one.
+// It runs from I_InitGraphics, before the game sets a palette, so the
+// palette tables are cleared afterwards instead of being saved on the
+// small system stack.
+//
+static void I_CheckBlit (void)
+{
+	uint32_t saved_frame_buffer;
+	uint16_t *ref, *out;
+	byte *indexed;
+	unsigned int ref_cycles, out_cycles, unstretched_cycles;
+	int i, mismatches;
+
+	for (i = 0; i < SCREENWIDTH * SCREENHEIGHT; i++)
+	{
+		I_VideoBuffer[i] = (byte)(i * 7 + i / SCREENWIDTH);
+	}
+
+	for (i = 0; i < 256; i++)
+	{
+		clut_palette[i] = (uint32_t)(i * 0x010307 + 0x081028) & 0xFFFFFF;
+		rgb565_palette[i] = GFX_RGB565((clut_palette[i] >> 16) & 0xFF,
+									   (clut_palette[i] >> 8) & 0xFF,
+									   clut_palette[i] & 0xFF);
+	}
+
+	ref_cycles = I_GetCycles ();
+
+	if (aspect_ratio_correct)
+	{
+		I_BlitStretchReference (0, 0, SCREENWIDTH, SCREENHEIGHT);
+	}
+	else
+	{
+		I_BlitReference (0, 0, SCREENWIDTH, SCREENHEIGHT);
+	}
+
+	ref_cycles = I_GetCycles () - ref_cycles;
+	ref = (uint16_t*)lcd_frame_buffer;
+
+	lcd_refresh ();
+
+	indexed = NULL;
+	saved_frame_buffer = lcd_frame_buffer;
+
+	if (video_clut)
+	{
+		indexed = (byte*)Z_Malloc (GFX_MAX_WIDTH * GFX_MAX_HEIGHT, PU_STATIC, NULL);
+		lcd_frame_buffer = (uint32_t)indexed;
+	}
+
+	out_cycles = I_GetCycles ();
+	blit_func (0, 0, SCREENWIDTH, SCREENHEIGHT);
+	out_cycles = I_GetCycles () - out_cycles;
+	out = (uint16_t*)lcd_frame_buffer;
+
+	mismatches = 0;
+
+	for (i = 0; i < GFX_MAX_WIDTH * GFX_MAX_HEIGHT; i++)
+	{
+		if (i % GFX_MAX_WIDTH >= screen_lcd_x
+		 && ref[i] != (indexed != NULL ? I_ClutPixel (indexed, i) : out[i]))
+		{
+			mismatches++;
+		}
+	}
+
+	printf ("I_CheckBlit: engine %d%s%s: %u cycles/frame, reference: %u cycles/frame, %d pixels differ\n",
+			video_blit, video_clut ? " (indexed)" : "", aspect_ratio_correct ? " (stretched)" : "",
+			out_cycles, ref_cycles, mismatches);
+
+	if (aspect_ratio_correct)
+	{
+		unstretched_cycles = I_GetCycles ();
+
+		if (video_clut)
+		{
+			I_BlitIndexed (0, 0, SCREENWIDTH, SCREENHEIGHT);
+		}
+		else
+		{
+			blit_funcs[video_blit] (0, 0, SCREENWIDTH, SCREENHEIGHT);
+		}
+
+		unstretched_cycles = I_GetCycles () - unstretched_cycles;
+
+		printf ("I_CheckBlit: unstretched engine: %u cycles/frame\n", unstretched_cycles);
+	}
+
+	lcd_frame_buffer = saved_frame_buffer;
+
+	if (indexed != NULL)
+	{
+		Z_Free (indexed);
+	}
+
+	memset (I_VideoBuffer, 0, SCREENWIDTH * SCREENHEIGHT);
+	memset (rgb565_palette, 0, sizeof (rgb565_palette));
+	memset (clut_palette, 0, sizeof (clut_palette));
+}
+
 void I_InitGraphics (void)
 {
 	gfx_image_t keys_img;
@@ -122,6 +746,48 @@ void I_InitGraphics (void)
 
 	I_VideoBuffer = (byte*)Z_Malloc (SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
 
+	if (video_blit < 0 || video_blit >= NUM_BLITS)
+	{
+		video_blit = BLIT_TILED;
+	}
+
+	if (aspect_ratio_correct)
+	{
+		screen_lcd_x = 0;
+
+		// keep PLAYPAL from being purged while the tables are allocated
+
+		stretch_tables = I_GetStretchTables (W_CacheLumpName (DEH_String ("PLAYPAL"), PU_STATIC));
+		W_ReleaseLumpName (DEH_String ("PLAYPAL"));
+		blit_func = video_clut ? I_BlitStretchedIndexed : I_BlitStretched;
+	}
+	else
+	{
+		screen_lcd_x = SCREEN_LCD_X;
+		blit_func = video_clut ? I_BlitIndexed : blit_funcs[video_blit];
+	}
+
+	if (video_blit_check)
+	{
+		I_CheckBlit ();
+	}
+
+	// flip between three buffers without waiting for the vertical blank
+
+	if (video_clut)
+	{
+		lcd_indexed_init (screen_lcd_x);
+	}
+	else
+	{
+		lcd_triple_buffer_init ();
+	}
+
+	// no buffer shows the game yet
+
+	M_ClearBox (dirtybox);
+	full_blits = lcd_frame_buffers;
+
 	screenvisible = true;
 }
 
@@ -308,32 +974,187 @@ void I_GetEvent (void)
 void I_StartTic (void)
 {
 	I_GetEvent();
+
+	// 'z' on the debug UART prints the zone stats
+	if (debug_char == 'z')
+	{
+		debug_char = 0;
+		Z_PrintStats ();
+	}
 }
 
 void I_UpdateNoBlit (void)
 {
 }
 
+//
+// Update the signatures of lines l1 <= l < l2 of I_VideoBuffer and
+// return whether any of them differs from the line last converted.
+// The signature is FNV-1a over 32-bit words.
+//
+static boolean I_UpdateSignatures (int l1, int l2)
+{
+	const uint32_t *src;
+	uint32_t sig;
+	boolean changed;
+	int l, i;
+
+	changed = false;
+
+	for (l = l1; l < l2; l++)
+	{
+		src = (const uint32_t*)(I_VideoBuffer + l * SCREENLINELENGTH);
+		sig = 2166136261u;
+
+		for (i = 0; i < SCREENLINELENGTH / 4; i++)
+		{
+			sig = (sig ^ src[i]) * 16777619u;
+		}
+
+		if (sig != line_signatures[l])
+		{
+			line_signatures[l] = sig;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
 void I_FinishUpdate (void)
 {
-	int x, y;
-	byte index;
+	int x1, y1, x2, y2;
+	int l1, l2;
+	int i;
+
+	blit_cycles = I_GetCycles ();
+
+	if (melt_drawn)
+	{
+		// I_DrawMelt has drawn this frame already
 
-	lcd_vsync = false;
+		melt_drawn = false;
 
-	for (y = 0; y < SCREENHEIGHT; y++)
+		x1 = x2 = 0;
+		y1 = y2 = 0;
+	}
+	else if (full_blits > 0)
+	{
+		full_blits--;
+
+		x1 = 0;
+		y1 = 0;
+		x2 = SCREENWIDTH;
+		y2 = SCREENHEIGHT;
+
+		I_UpdateSignatures (0, SCREENLINES);
+	}
+	else
 	{
-		for (x = 0; x < SCREENWIDTH; x++)
+		// lines drawn to since the last frame shown
+
+#ifdef FEATURE_COLUMN_MAJOR
+		l1 = (dirtybox[BOXLEFT] < 0) ? 0 : dirtybox[BOXLEFT];
+		l2 = (dirtybox[BOXRIGHT] >= SCREENWIDTH) ? SCREENWIDTH : dirtybox[BOXRIGHT] + 1;
+#else
+		l1 = (dirtybox[BOXBOTTOM] < 0) ? 0 : dirtybox[BOXBOTTOM];
+		l2 = (dirtybox[BOXTOP] >= SCREENHEIGHT) ? SCREENHEIGHT : dirtybox[BOXTOP] + 1;
+#endif
+
+		// if they equal the frame shown, neither convert nor show it;
+		// keep dirtybox, a line might still differ
+
+		if (!I_UpdateSignatures (l1, l2) && !palette_changed)
 		{
-			index = I_VideoBuffer[y * SCREENWIDTH + x];
+			blit_frames_unchanged++;
+			blit_skipped = SCREENWIDTH * SCREENHEIGHT;
+			blit_cycles = I_GetCycles () - blit_cycles;
 
-			((uint16_t*)lcd_frame_buffer)[x * GFX_MAX_WIDTH + (GFX_MAX_WIDTH - y - 1)] = rgb565_palette[index];
+			blit_cycles_total += blit_cycles;
+			blit_skipped_total += blit_skipped;
+
+			return;
+		}
+
+		// union of this frame's and the previous frames' dirtyboxes
+		// (BOXBOTTOM is the lowest y, i.e. the top of the screen)
+
+		x1 = dirtybox[BOXLEFT];
+		y1 = dirtybox[BOXBOTTOM];
+		x2 = dirtybox[BOXRIGHT];
+		y2 = dirtybox[BOXTOP];
+
+		for (i = 0; i < lcd_frame_buffers - 1; i++)
+		{
+			x1 = last_dirtybox[i][BOXLEFT] < x1 ? last_dirtybox[i][BOXLEFT] : x1;
+			y1 = last_dirtybox[i][BOXBOTTOM] < y1 ? last_dirtybox[i][BOXBOTTOM] : y1;
+			x2 = last_dirtybox[i][BOXRIGHT] > x2 ? last_dirtybox[i][BOXRIGHT] : x2;
+			y2 = last_dirtybox[i][BOXTOP] > y2 ? last_dirtybox[i][BOXTOP] : y2;
 		}
+
+		// clip to the screen, x2 and y2 exclusive
+
+		x1 = (x1 < 0) ? 0 : x1;
+		y1 = (y1 < 0) ? 0 : y1;
+		x2 = (x2 >= SCREENWIDTH) ? SCREENWIDTH : x2 + 1;
+		y2 = (y2 >= SCREENHEIGHT) ? SCREENHEIGHT : y2 + 1;
 	}
 
-	lcd_refresh ();
+	if (x1 < x2 && y1 < y2)
+	{
+		blit_func (x1, y1, x2, y2);
+
+		blit_skipped = SCREENWIDTH * SCREENHEIGHT - (x2 - x1) * (y2 - y1);
+	}
+	else
+	{
+		blit_skipped = SCREENWIDTH * SCREENHEIGHT;
+	}
+
+	memmove (last_dirtybox[1], last_dirtybox[0], sizeof (last_dirtybox) - sizeof (last_dirtybox[0]));
+	memcpy (last_dirtybox[0], dirtybox, sizeof (dirtybox));
+	M_ClearBox (dirtybox);
 
-	lcd_vsync = true;
+	blit_cycles = I_GetCycles () - blit_cycles;
+	blit_frames++;
+	palette_changed = false;
+
+	blit_cycles_total += blit_cycles;
+	blit_skipped_total += blit_skipped;
+
+	// show this frame at the next vertical blank, continue drawing
+	// into the third buffer right away
+
+	lcd_flip ();
+}
+
+//
+// I_PrintBlitStats
+// Prints the scanout statistics since startup, averaged over all
+// frames including the unchanged ones, and lcd_flip's waits.
+//
+void I_PrintBlitStats (void)
+{
+	unsigned int frames;
+
+	frames = blit_frames + blit_frames_unchanged;
+
+	if (frames == 0)
+	{
+		return;
+	}
+
+	printf ("%u frames shown, %u unchanged frames skipped\n",
+			blit_frames, blit_frames_unchanged);
+
+	printf ("%u blit cycles and %u of %u pixels skipped per frame\n",
+			(unsigned int)(blit_cycles_total / frames),
+			(unsigned int)(blit_skipped_total / frames),
+			SCREENWIDTH * SCREENHEIGHT);
+
+	printf ("%u flips waited for the previous one, %u cycles per wait\n",
+			(unsigned int)lcd_flip_waits,
+			lcd_flip_waits ? (unsigned int)(lcd_flip_wait_cycles / lcd_flip_waits) : 0);
 }
 
 //
@@ -344,6 +1165,63 @@ void I_ReadScreen (byte* scr)
     memcpy (scr, I_VideoBuffer, SCREENWIDTH * SCREENHEIGHT);
 }
 
+//
+// I_ReadWipeScreen
+// Converts the screen into spare LCD buffer n, in the layout of the
+// frame buffers, so the wipe needs neither zone memory nor conversions.
+//
+void I_ReadWipeScreen (int n)
+{
+	uint32_t saved_frame_buffer;
+
+	saved_frame_buffer = lcd_frame_buffer;
+	lcd_frame_buffer = lcd_spare_buffer (n);
+
+	blit_func (0, 0, SCREENWIDTH, SCREENHEIGHT);
+
+	lcd_frame_buffer = saved_frame_buffer;
+}
+
+//
+// I_DrawMelt
+// Doom column x is LCD line x, stored bottom to top, so moving a column
+// down is a copy along the line: its first part is the start screen
+// shifted by the melted lines, the rest is the end screen.
+//
+void I_DrawMelt (int* y)
+{
+	byte *start, *end, *out;
+	int bpp, pitch, offset, height;
+	int x, dy;
+
+	// layout of the blit engines: RGB565 lines span the LCD, indexed
+	// lines begin at screen_lcd_x
+
+	bpp = video_clut ? 1 : 2;
+	pitch = video_clut ? GFX_MAX_WIDTH - screen_lcd_x : GFX_MAX_WIDTH;
+	offset = video_clut ? 0 : screen_lcd_x;
+	height = GFX_MAX_WIDTH - screen_lcd_x;
+
+	for (x = 0; x < SCREENWIDTH; x++)
+	{
+		dy = y[x / 2];
+		dy = (dy <= 0) ? 0 : ((dy >= SCREENHEIGHT) ? height : dy * height / SCREENHEIGHT);
+
+		start = (byte*)lcd_spare_buffer (0) + (x * pitch + offset) * bpp;
+		end = (byte*)lcd_spare_buffer (1) + (x * pitch + offset) * bpp;
+		out = (byte*)lcd_frame_buffer + (x * pitch + offset) * bpp;
+
+		memcpy (out, start + dy * bpp, (height - dy) * bpp);
+		memcpy (out + (height - dy) * bpp, end + (height - dy) * bpp, dy * bpp);
+	}
+
+	melt_drawn = true;
+
+	// all buffers have to be converted after the wipe
+
+	full_blits = lcd_frame_buffers;
+}
+
 //
 // I_SetPalette
 //
@@ -360,8 +1238,27 @@ void I_SetPalette (byte* palette)
 									   gammatable[usegamma][c->g],
 									   gammatable[usegamma][c->b]);
 
+		clut_palette[i] = (gammatable[usegamma][c->r] << 16)
+						| (gammatable[usegamma][c->g] << 8)
+						| gammatable[usegamma][c->b];
+
 		palette += 3;
 	}
+
+	if (video_clut)
+	{
+		// the LCD looks up the colors, shown with the next frame
+
+		lcd_set_clut (clut_palette);
+	}
+	else
+	{
+		// all buffers have to be converted with the new palette
+
+		full_blits = lcd_frame_buffers;
+	}
+
+	palette_changed = true;
 }
 
 // Given an RGB value, find the closest matching palette index.
@@ -426,6 +1323,10 @@ void I_EnableLoadingDisk (void)
 
 void I_BindVideoVariables (void)
 {
+	M_BindVariable ("video_blit",           &video_blit);
+	M_BindVariable ("video_blit_check",     &video_blit_check);
+	M_BindVariable ("video_clut",           &video_clut);
+	M_BindVariable ("aspect_ratio_correct", &aspect_ratio_correct);
 }
 
 void I_DisplayFPSDots (boolean dots_on)
@@ -21,12 +21,32 @@
 #define __I_VIDEO__
 
 #include "doomtype.h"
+#include "doomfeatures.h"
 
 // Screen width and height.
 
 #define SCREENWIDTH  320
 #define SCREENHEIGHT 200
 
+// Layout of I_VideoBuffer and the other screen buffers: the offset
+// between horizontally and vertically adjacent pixels.
+
+#ifdef FEATURE_COLUMN_MAJOR
+#define SCREENXSTEP  SCREENHEIGHT
+#define SCREENYSTEP  1
+#else
+#define SCREENXSTEP  1
+#define SCREENYSTEP  SCREENWIDTH
+#endif
+
+// Offset of pixel (x, y) in a screen buffer.
+
+#define SCREENOFS(x, y) ((x) * SCREENXSTEP + (y) * SCREENYSTEP)
+
+// Size of a screen buffer holding the top h lines of the screen.
+
+#define SCREENAREA(h) (SCREENOFS(SCREENWIDTH - 1, (h) - 1) + 1)
+
 // Screen width used for "squash" scale functions
 
 #define SCREENWIDTH_4_3 256
@@ -109,6 +129,13 @@ void I_FinishUpdate (void);
 
 void I_ReadScreen (byte* scr);
 
+// Screen wipe on the LCD: save the current screen, converted, as the
+// start (0) or end (1) screen of the wipe, and draw the melt of both
+// as the next frame, with column pair i moved down by y[i] lines.
+
+void I_ReadWipeScreen (int n);
+void I_DrawMelt (int* y);
+
 void I_BeginRead (void);
 void I_EndRead (void);
 
@@ -153,4 +180,20 @@ extern int screen_bpp;
 extern int fullscreen;
 extern int aspect_ratio_correct;
 
+// Scanout statistics of the last frame: cycles spent converting it and
+// pixels left untouched because they were outside the dirty area.
+
+extern unsigned int blit_cycles;
+extern unsigned int blit_skipped;
+
+// Frames shown, and frames skipped because they equal the frame shown
+// last, since startup.
+
+extern unsigned int blit_frames;
+extern unsigned int blit_frames_unchanged;
+
+// Print the scanout statistics, averaged per frame, on the debug UART.
+
+void I_PrintBlitStats (void);
+
 #endif
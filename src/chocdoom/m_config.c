@@ -708,11 +708,76 @@ static default_t extra_defaults_list[] =
 
     //!
     // If non-zero, the screen will be stretched vertically to display
-    // correctly on a square pixel video mode.
+    // correctly on a square pixel video mode.  On the LCD, the
+    // stretched screen covers the touch keys.
     //
 
     CONFIG_VARIABLE_INT(aspect_ratio_correct),
 
+    //!
+    // Blit engine used to copy the screen to the LCD:
+    // 0 = reference per-pixel loop, 1 = tiled 32-bit blit (a linear
+    // per-column conversion when the screen is stored column-major).
+    //
+
+    CONFIG_VARIABLE_INT(video_blit),
+
+    //!
+    // If non-zero, the blit engine is compared against the reference
+    // loop at startup and the cycles per frame are printed.
+    //
+
+    CONFIG_VARIABLE_INT(video_blit_check),
+
+    //!
+    // If non-zero, the screen is shown through an 8-bit indexed LCD
+    // layer and the palette is loaded into the LCD's color look-up
+    // table, so palette changes need no conversion of the screen.
+    // video_blit is not used then.
+    //
+
+    CONFIG_VARIABLE_INT(video_clut),
+
+    //!
+    // If non-zero, the column drawers are compared against the
+    // reference drawer on every wall texture column at startup, and
+    // the cycles spent in both are printed.
+    //
+
+    CONFIG_VARIABLE_INT(draw_column_check),
+
+    //!
+    // If non-zero, the span drawers are compared against the
+    // reference drawers on every flat at startup, and the cycles
+    // spent in both are printed.
+    //
+
+    CONFIG_VARIABLE_INT(draw_span_check),
+
+    //!
+    // If non-zero, the sprite sort is compared against the original
+    // selection sort on random sprite sets at startup.
+    //
+
+    CONFIG_VARIABLE_INT(sprite_sort_check),
+
+    //!
+    // If non-zero, FixedDiv is compared against the original 64-bit
+    // division on edge cases and random operands at startup, and the
+    // cycles spent in both are printed.
+    //
+
+    CONFIG_VARIABLE_INT(fixed_div_check),
+
+    //!
+    // If non-zero, each intercept of a trace taken from the heap is
+    // compared with the one the original scan finds, and the game
+    // stops with an error if they differ. Play demos with this set
+    // to check that they stay in sync.
+    //
+
+    CONFIG_VARIABLE_INT(intercept_check),
+
     //!
     // Number of milliseconds to wait on startup after the video mode
     // has been set, before the game will start.  This allows the
@@ -855,6 +920,62 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(vanilla_demo_limit),
 
+    //!
+    // If non-zero, the renderer keeps the Vanilla limits of 128
+    // visplanes, 256 drawsegs, 128 sprites, 20480 openings and 32
+    // solid segs. Otherwise they grow as far as the render arena
+    // allows.
+    //
+
+    CONFIG_VARIABLE_INT(vanilla_render_limits),
+
+    //!
+    // Size in KiB of the arena the renderer takes its visplanes,
+    // drawsegs, sprites and openings from each frame.
+    //
+
+    CONFIG_VARIABLE_INT(render_arena_size),
+
+    //!
+    // Size in KiB of the cache of wall columns with the light level
+    // applied, at most 4. Zero turns the cache off.
+    //
+
+    CONFIG_VARIABLE_INT(column_cache_size),
+
+    //!
+    // Render time per frame in milliseconds. If non-zero, the view
+    // switches to low detail and then to smaller sizes while frames
+    // take longer, and each switch is logged.
+    //
+
+    CONFIG_VARIABLE_INT(frame_budget),
+
+    //!
+    // How many percent under frame_budget the render time has to be
+    // before the view switches back to a larger size or high detail.
+    //
+
+    CONFIG_VARIABLE_INT(frame_budget_hysteresis),
+
+    //!
+    // If non-zero, a line of zone stats is printed to the debug UART
+    // every this many tics: bytes and blocks per tag with their peaks,
+    // free space and fragmentation, purges and lumps read again.
+    // Each line takes about 20ms to send at 115200 baud.
+    //
+
+    CONFIG_VARIABLE_INT(zone_stats_tics),
+
+    //!
+    // If non-zero, every zone allocation, free, tag change and purge
+    // is printed to the debug UART as a line starting with "Z ". A
+    // log of a demo played like this can be replayed against either
+    // zone backend with test/zone_test. It slows the game down a lot.
+    //
+
+    CONFIG_VARIABLE_INT(zone_trace),
+
     //!
     // If non-zero, the game behaves like Vanilla Doom, always assuming
     // an American keyboard mapping.  If this has a value of zero, the
@@ -18,10 +18,12 @@
 
 
 
+#include "stdio.h"
 #include "stdlib.h"
 
 #include "doomtype.h"
 #include "i_system.h"
+#include "i_timer.h"
 
 #include "m_fixed.h"
 
@@ -41,10 +43,11 @@ FixedMul
 
 
 //
-// FixedDiv, C version.
+// FixedDivReference
+// The original 64-bit division, kept for M_CheckFixedDiv
+//  and for the one dividend FixedDiv does not handle.
 //
-
-fixed_t FixedDiv(fixed_t a, fixed_t b)
+static fixed_t FixedDivReference (fixed_t a, fixed_t b)
 {
     if ((abs(a) >> 14) >= abs(b))
     {
@@ -60,3 +63,211 @@ fixed_t FixedDiv(fixed_t a, fixed_t b)
     }
 }
 
+
+
+//
+// FixedDivUnsigned
+// (a << 16) / b for a quotient below 2^31, using only
+//  32-bit divides, which the Cortex-M4 does in hardware
+//  (the 64-bit division is a library call).
+// A divisor above 1.0 is normalized so its top bit is set,
+//  and the quotient is found one halfword at a time from
+//  the divisor's top halfword, with at most two corrections
+//  per halfword (Knuth, algorithm D; Hacker's Delight divlu).
+//
+static unsigned int FixedDivUnsigned (unsigned int a, unsigned int b)
+{
+    unsigned int	vn1, vn0;
+    unsigned int	un32, un21, un10, un1, un0;
+    unsigned int	q1, q0, rhat;
+    int			s;
+
+    if (b <= 0xffff)
+    {
+	// the remainder fits in a halfword, so two plain divides do
+	q1 = a / b;
+	return (q1 << 16) + (((a - q1 * b) << 16) / b);
+    }
+
+    s = __builtin_clz (b);
+    b <<= s;
+    vn1 = b >> 16;
+    vn0 = b & 0xffff;
+
+    // dividend a << (16 + s), split into a high word and two halfwords
+    un32 = a >> (16 - s);
+    un10 = a << (16 + s);
+    un1 = un10 >> 16;
+    un0 = un10 & 0xffff;
+
+    q1 = un32 / vn1;
+    rhat = un32 - q1 * vn1;
+
+    while (q1 > 0xffff || q1 * vn0 > ((rhat << 16) | un1))
+    {
+	q1--;
+	rhat += vn1;
+	if (rhat > 0xffff)
+	    break;
+    }
+
+    un21 = (un32 << 16) + un1 - q1 * b;
+    q0 = un21 / vn1;
+    rhat = un21 - q0 * vn1;
+
+    while (q0 > 0xffff || q0 * vn0 > ((rhat << 16) | un0))
+    {
+	q0--;
+	rhat += vn1;
+	if (rhat > 0xffff)
+	    break;
+    }
+
+    return (q1 << 16) | q0;
+}
+
+
+
+//
+// FixedDiv
+// Same results as FixedDivReference, overflow included.
+// Past the guard, |a| < (|b| + 1) << 14, so the quotient
+//  magnitude is below 2^31 and the sign can be put back on
+//  the unsigned quotient, which is truncated toward zero
+//  just like the signed 64-bit division.
+//
+fixed_t FixedDiv(fixed_t a, fixed_t b)
+{
+    unsigned int	q;
+
+    if ((abs(a) >> 14) >= abs(b))
+    {
+	return (a^b) < 0 ? INT_MIN : INT_MAX;
+    }
+
+    // abs(INT_MIN) slips past the guard and the 64-bit
+    //  quotient is then cut down to 32 bits; keep that
+    if (a == INT_MIN)
+	return FixedDivReference (a, b);
+
+    q = FixedDivUnsigned (abs(a), abs(b));
+
+    return (a^b) < 0 ? -(fixed_t) q : (fixed_t) q;
+}
+
+
+
+//
+// M_CheckFixedDiv
+// Compares FixedDiv against FixedDivReference on edge cases
+//  and random operands of every magnitude, and prints the
+//  cycles spent in both.
+//
+int		fixed_div_check = 0;
+
+#define FIXEDDIVTESTS	(1<<20)
+
+// keeps the timed divisions from being optimized away
+static volatile fixed_t	fixeddivsink;
+
+static const fixed_t fixeddivedges[] =
+{
+    0, 1, 2, 3, 0x3fff, 0x4000, 0x4001, 0x7fff, 0x8000, 0xffff,
+    FRACUNIT, FRACUNIT+1, 0x1ffff, 0x20000, 0x7fffffff, 0x7ffffffe,
+    0x40000000, 0x3fffffff, 0x12345678, -1, -2, -FRACUNIT,
+    -FRACUNIT-1, -0x7fffffff, INT_MIN, INT_MIN+1
+};
+
+void M_CheckFixedDiv (void)
+{
+    unsigned int	seed;
+    unsigned int	fastcycles;
+    unsigned int	refcycles;
+    unsigned int	start;
+    fixed_t		a, b;
+    int			mismatches;
+    int			tests;
+    int			i, j;
+
+    mismatches = 0;
+    tests = 0;
+
+    for (i = 0; i < arrlen(fixeddivedges); i++)
+    {
+	for (j = 0; j < arrlen(fixeddivedges); j++)
+	{
+	    a = fixeddivedges[i];
+	    b = fixeddivedges[j];
+
+	    // b == 0 with INT_MIN divides by zero in both versions
+	    if (b == 0 && a == INT_MIN)
+		continue;
+
+	    if (FixedDiv (a, b) != FixedDivReference (a, b))
+		mismatches++;
+
+	    // either side of the overflow guard
+	    if (b != INT_MIN && b != 0)
+	    {
+		b = abs(a >> 14) + (b & 3) - 1;
+
+		if (b != 0 && FixedDiv (a, b) != FixedDivReference (a, b))
+		    mismatches++;
+		if (FixedDiv (a, -b) != FixedDivReference (a, -b))
+		    mismatches++;
+	    }
+
+	    tests += 3;
+	}
+    }
+
+    // xorshift, so operands cover all 32 bits
+    seed = 0x2545f491;
+
+    for (i = 0; i < FIXEDDIVTESTS; i++)
+    {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	a = (fixed_t) seed >> (seed & 31);
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	b = (fixed_t) seed >> (seed & 31);
+
+	if (b == 0)
+	    b = 1;
+
+	if (FixedDiv (a, b) != FixedDivReference (a, b))
+	    mismatches++;
+
+	tests++;
+    }
+
+    // time both on the same mix of operands
+    start = I_GetCycles ();
+
+    for (i = 0; i < 4096; i++)
+    {
+	a = (i * 0x9e3779b1) >> (i & 15);
+	b = ((i * 0x85ebca6b) >> (i & 7 ? 8 : 24)) | 1;
+	fixeddivsink = FixedDiv (a, b);
+    }
+
+    fastcycles = I_GetCycles () - start;
+    start = I_GetCycles ();
+
+    for (i = 0; i < 4096; i++)
+    {
+	a = (i * 0x9e3779b1) >> (i & 15);
+	b = ((i * 0x85ebca6b) >> (i & 7 ? 8 : 24)) | 1;
+	fixeddivsink = FixedDivReference (a, b);
+    }
+
+    refcycles = I_GetCycles () - start;
+
+    printf ("M_CheckFixedDiv: %d of %d quotients differ, "
+	    "%u cycles, reference %u cycles\n",
+	    mismatches, tests, fastcycles, refcycles);
+}
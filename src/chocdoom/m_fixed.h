@@ -34,6 +34,10 @@ typedef int fixed_t;
 fixed_t FixedMul	(fixed_t a, fixed_t b);
 fixed_t FixedDiv	(fixed_t a, fixed_t b);
 
+extern int	fixed_div_check;
+
+void M_CheckFixedDiv (void);
+
 
 
 #endif
@@ -49,6 +49,9 @@ T_MovePlane
 {
     boolean	flag;
     fixed_t	lastpos;
+
+    // sight through this sector may change
+    P_ClearSightCache ();
 	
     switch(floorOrCeiling)
     {
@@ -270,7 +273,7 @@ EV_DoFloor
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = Z_SlabAlloc (&floorpool);
 	P_AddThinker (&floor->thinker);
 	sec->specialdata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -473,7 +476,7 @@ EV_BuildStairs
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = Z_SlabAlloc (&floorpool);
 	P_AddThinker (&floor->thinker);
 	sec->specialdata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -526,7 +529,7 @@ EV_BuildStairs
 					
 		sec = tsec;
 		secnum = newsecnum;
-		floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+		floor = Z_SlabAlloc (&floorpool);
 
 		P_AddThinker (&floor->thinker);
 
@@ -24,6 +24,8 @@
 #include "r_local.h"
 #endif
 
+#include "z_zone.h"
+
 #define FLOATSPEED		(FRACUNIT*4)
 
 
@@ -71,6 +73,17 @@ void P_InitThinkers (void);
 void P_AddThinker (thinker_t* thinker);
 void P_RemoveThinker (thinker_t* thinker);
 
+// one slab pool per kind of thinker, emptied with the level
+extern slabpool_t	mobjpool;
+extern slabpool_t	ceilingpool;
+extern slabpool_t	doorpool;
+extern slabpool_t	floorpool;
+extern slabpool_t	platpool;
+extern slabpool_t	fireflickerpool;
+extern slabpool_t	lightflashpool;
+extern slabpool_t	strobepool;
+extern slabpool_t	glowpool;
+
 
 //
 // P_PSPR
@@ -157,6 +170,8 @@ typedef struct
 extern intercept_t	intercepts[MAXINTERCEPTS];
 extern intercept_t*	intercept_p;
 
+extern int		intercept_check;
+
 typedef boolean (*traverser_t) (intercept_t *in);
 
 fixed_t P_AproxDistance (fixed_t dx, fixed_t dy);
@@ -227,6 +242,13 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+
+// Forgets the sight checks made so far, once a tic and whenever
+//  a floor or ceiling moves.
+void P_ClearSightCache (void);
+
+extern unsigned int	sight_cache_hits;
+extern unsigned int	sight_cache_misses;
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
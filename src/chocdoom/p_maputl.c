@@ -26,6 +26,7 @@
 
 
 #include "m_bbox.h"
+#include "i_system.h"
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -673,10 +674,94 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
 }
 
 
+//
+// Intercepts are handed to the traverser nearest first, and the
+//  earliest added first among equally near ones. They are taken
+//  from a binary heap in that order, instead of scanning the whole
+//  array for each one.
+//
+static intercept_t*	interceptheap[MAXINTERCEPTS];
+
+// Bumped by P_PathTraverse when it starts filling intercepts[].
+static unsigned int	interceptgeneration;
+
+// If non-zero, every intercept taken from the heap is compared with
+// the one the original scan of intercepts[] would have found. Playing
+// a demo with this set checks that it stays in sync.
+
+int		intercept_check = 0;
+
+#define INTERCEPTBEFORE(a, b) \
+    ((a)->frac < (b)->frac || ((a)->frac == (b)->frac && (a) < (b)))
+
+static void P_SiftInterceptDown (int count, int i)
+{
+    intercept_t*	in;
+    int			child;
+
+    in = interceptheap[i];
+
+    while ((child = i*2 + 1) < count)
+    {
+	if (child + 1 < count
+	    && INTERCEPTBEFORE(interceptheap[child + 1], interceptheap[child]))
+	{
+	    child++;
+	}
+
+	if (!INTERCEPTBEFORE(interceptheap[child], in))
+	    break;
+
+	interceptheap[i] = interceptheap[child];
+	i = child;
+    }
+
+    interceptheap[i] = in;
+}
+
+
+//
+// P_CheckIntercept
+// Scans intercepts[] for the nearest one like the original code
+//  and stops with an error if the heap handed out another one.
+//
+static void P_CheckIntercept (intercept_t* in)
+{
+    intercept_t*	scan;
+    intercept_t*	nearest;
+    fixed_t		dist;
+
+    dist = INT_MAX;
+    nearest = NULL;
+
+    for (scan = intercepts ; scan<intercept_p ; scan++)
+    {
+	if (scan->frac < dist)
+	{
+	    dist = scan->frac;
+	    nearest = scan;
+	}
+    }
+
+    // with only consumed intercepts left both end the trace
+    if (dist != in->frac || (nearest != NULL && nearest != in))
+    {
+	I_Error ("P_TraverseIntercepts: heap took intercept %i at %i, "
+		 "scan found %i at %i",
+		 (int) (in - intercepts), in->frac,
+		 nearest ? (int) (nearest - intercepts) : -1, dist);
+    }
+}
+
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
 // for all lines.
+// If the traverser starts another trace, intercepts[] is refilled
+//  under us, so the rest is found by scanning the array like the
+//  original code did. The same happens if there are more intercepts
+//  than the heap holds.
 // 
 boolean
 P_TraverseIntercepts
@@ -684,23 +769,54 @@ P_TraverseIntercepts
   fixed_t	maxfrac )
 {
     int			count;
+    int			heapcount;
+    unsigned int	generation;
     fixed_t		dist;
     intercept_t*	scan;
     intercept_t*	in;
+    int			i;
 	
     count = intercept_p - intercepts;
     
     in = 0;			// shut up compiler warning
+
+    if (count <= MAXINTERCEPTS)
+    {
+	heapcount = count;
+
+	for (i = 0; i < count; i++)
+	    interceptheap[i] = &intercepts[i];
+
+	for (i = count/2 - 1; i >= 0; i--)
+	    P_SiftInterceptDown (count, i);
+    }
+    else
+    {
+	heapcount = -1;
+    }
+
+    generation = interceptgeneration;
 	
     while (count--)
     {
-	dist = INT_MAX;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
+	if (heapcount >= 0)
+	{
+	    in = interceptheap[0];
+	    dist = in->frac;
+
+	    if (intercept_check)
+		P_CheckIntercept (in);
+	}
+	else
 	{
-	    if (scan->frac < dist)
+	    dist = INT_MAX;
+	    for (scan = intercepts ; scan<intercept_p ; scan++)
 	    {
-		dist = scan->frac;
-		in = scan;
+		if (scan->frac < dist)
+		{
+		    dist = scan->frac;
+		    in = scan;
+		}
 	    }
 	}
 	
@@ -723,6 +839,16 @@ P_TraverseIntercepts
 	    return false;	// don't bother going farther
 
 	in->frac = INT_MAX;
+
+	if (generation != interceptgeneration)
+	{
+	    heapcount = -1;
+	}
+	else if (heapcount >= 0)
+	{
+	    interceptheap[0] = interceptheap[--heapcount];
+	    P_SiftInterceptDown (heapcount, 0);
+	}
     }
 	
     return true;		// everything was traversed
@@ -891,6 +1017,7 @@ P_PathTraverse
 		
     validcount++;
     intercept_p = intercepts;
+    interceptgeneration++;
 	
     if ( ((x1-bmaporgx)&(MAPBLOCKSIZE-1)) == 0)
 	x1 += FRACUNIT;	// don't side exactly on a line
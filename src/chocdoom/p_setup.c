@@ -791,6 +791,9 @@ P_SetupLevel
     lumpnum = W_GetNumForName (lumpname);
 	
     leveltime = 0;
+
+    bsp_nodes_visited = 0;
+    bsp_bbox_rejects = 0;
 	
     // note: most of this ordering is important	
     P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
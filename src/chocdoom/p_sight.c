@@ -39,6 +39,38 @@ fixed_t		t2y;
 
 int		sightcounts[2];
 
+//
+// Sight cache.
+// The BSP walk only depends on the looker's eye, the target's
+//  position and height range, and the floor and ceiling heights,
+//  so results are kept until the next tic or the next time a
+//  plane moves. Each entry also keeps the slopes the walk left,
+//  so a hit leaves the same state as the walk.
+//
+#define SIGHTCACHESIZE		256
+
+typedef struct
+{
+    unsigned int	generation;
+    fixed_t		x1, y1, z1;		// eye of the looker
+    fixed_t		x2, y2, bottom, top;	// target
+    fixed_t		topslope;
+    fixed_t		bottomslope;
+    boolean		result;
+
+} sightcache_t;
+
+static sightcache_t	sightcache[SIGHTCACHESIZE];
+static unsigned int	sightgeneration = 1;
+
+unsigned int		sight_cache_hits;
+unsigned int		sight_cache_misses;
+
+void P_ClearSightCache (void)
+{
+    sightgeneration++;
+}
+
 
 //
 // P_DivlineSide
@@ -307,6 +339,7 @@ P_CheckSight
     int		pnum;
     int		bytenum;
     int		bitnum;
+    sightcache_t*	sc;
     
     // First check for trivial rejection.
 
@@ -343,8 +376,40 @@ P_CheckSight
     strace.dx = t2->x - t1->x;
     strace.dy = t2->y - t1->y;
 
+    // unsigned, as the multiplications overflow
+    sc = &sightcache[(((unsigned) t1->x ^ ((unsigned) t1->y * 3)
+		       ^ ((unsigned) t2->x * 5) ^ ((unsigned) t2->y * 7)
+		       ^ (unsigned) sightzstart ^ (unsigned) t2->z) * 0x9e3779b1u)
+		     >> 24];
+
+    if (sc->generation == sightgeneration
+	&& sc->x1 == t1->x && sc->y1 == t1->y && sc->z1 == sightzstart
+	&& sc->x2 == t2->x && sc->y2 == t2->y
+	&& sc->bottom == bottomslope && sc->top == topslope)
+    {
+	sight_cache_hits++;
+	topslope = sc->topslope;
+	bottomslope = sc->bottomslope;
+	return sc->result;
+    }
+
+    sight_cache_misses++;
+
+    sc->generation = sightgeneration;
+    sc->x1 = t1->x;
+    sc->y1 = t1->y;
+    sc->z1 = sightzstart;
+    sc->x2 = t2->x;
+    sc->y2 = t2->y;
+    sc->bottom = bottomslope;
+    sc->top = topslope;
+
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+    sc->result = P_CrossBSPNode (numnodes-1);
+    sc->topslope = topslope;
+    sc->bottomslope = bottomslope;
+
+    return sc->result;
 }
 
 
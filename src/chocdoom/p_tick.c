@@ -28,7 +28,7 @@ int	leveltime;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
+// All thinkers should be allocated by Z_SlabAlloc
 // so they can be operated on uniformly.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
@@ -39,6 +39,18 @@ int	leveltime;
 // Both the head and tail of the thinker list.
 thinker_t	thinkercap;
 
+// Mobjs stay zone blocks: vanilla reads the target or tracer of a
+//  removed mobj, and what it finds there depends on the zone.
+slabpool_t	mobjpool = { "mobjs", sizeof(mobj_t), PU_LEVEL, true };
+slabpool_t	ceilingpool = { "ceilings", sizeof(ceiling_t), PU_LEVSPEC };
+slabpool_t	doorpool = { "doors", sizeof(vldoor_t), PU_LEVSPEC };
+slabpool_t	floorpool = { "floors", sizeof(floormove_t), PU_LEVSPEC };
+slabpool_t	platpool = { "plats", sizeof(plat_t), PU_LEVSPEC };
+slabpool_t	fireflickerpool = { "fire flickers", sizeof(fireflicker_t), PU_LEVSPEC };
+slabpool_t	lightflashpool = { "light flashes", sizeof(lightflash_t), PU_LEVSPEC };
+slabpool_t	strobepool = { "strobes", sizeof(strobe_t), PU_LEVSPEC };
+slabpool_t	glowpool = { "glows", sizeof(glow_t), PU_LEVSPEC };
+
 
 //
 // P_InitThinkers
@@ -103,7 +115,7 @@ void P_RunThinkers (void)
 	    // time to remove it
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
-	    Z_Free (currentthinker);
+	    Z_SlabFree (currentthinker);
 	}
 	else
 	{
@@ -138,6 +150,8 @@ void P_Ticker (void)
     }
     
 		
+    P_ClearSightCache ();
+
     for (i=0 ; i<MAXPLAYERS ; i++)
 	if (playeringame[i])
 	    P_PlayerThink (&players[i]);
@@ -0,0 +1,231 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Per-frame arena for the renderer's visplanes, drawsegs,
+//	 vissprites, openings and solid segs. Everything taken from
+//	 it during a frame is given back at once at the next frame.
+//
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "i_system.h"
+#include "z_zone.h"
+
+#include "r_arena.h"
+
+
+int			render_arena_size = 512;
+int			vanilla_render_limits = 0;
+
+#define MAXPOOLS	8
+
+static byte*		arena;
+static int		arenasize;
+
+// Bytes in use this frame, and the most used in any frame.
+static int		arenatop;
+static int		arenapeak;
+
+// The pools taken from the arena, for the statistics.
+static renderpool_t*	pools[MAXPOOLS];
+static int		numpools;
+
+
+//
+// R_InitArena
+//
+void R_InitArena (void)
+{
+    arenasize = render_arena_size * 1024;
+    arena = Z_Malloc (arenasize, PU_STATIC, NULL);
+    arenatop = 0;
+}
+
+
+//
+// R_ArenaAlloc
+// Returns NULL if the arena is exhausted.
+//
+void* R_ArenaAlloc (int size)
+{
+    void*	p;
+
+    size = (size + 7) & ~7;
+
+    if (arenatop + size > arenasize)
+	return NULL;
+
+    p = arena + arenatop;
+    arenatop += size;
+
+    if (arenatop > arenapeak)
+	arenapeak = arenatop;
+
+    return p;
+}
+
+
+//
+// R_ClearArena
+//
+void R_ClearArena (void)
+{
+    renderpool_t*	pool;
+    int			i;
+
+    for (i = 0; i < numpools; i++)
+    {
+	pool = pools[i];
+	pool->lastused = pool->used;
+
+	if (pool->used > pool->peak)
+	    pool->peak = pool->used;
+
+	pool->used = 0;
+    }
+
+    arenatop = 0;
+}
+
+
+//
+// R_ResetPool
+//
+void R_ResetPool (renderpool_t* pool)
+{
+    int		i;
+
+    for (i = 0; i < numpools; i++)
+    {
+	if (pools[i] == pool)
+	    break;
+    }
+
+    if (i == numpools)
+    {
+	if (numpools == MAXPOOLS)
+	    I_Error ("R_ResetPool: too many pools");
+
+	pools[numpools++] = pool;
+    }
+
+    pool->size = pool->limit;
+
+    // Start with room for the busiest frame so far.
+    if (!vanilla_render_limits && pool->peak > pool->size)
+	pool->size = pool->peak;
+
+    pool->base = R_ArenaAlloc (pool->size * pool->itemsize);
+
+    if (pool->base == NULL)
+    {
+	R_PrintArenaStats ();
+	I_Error ("R_ResetPool: render arena of %i KiB too small for %s",
+		 render_arena_size, pool->name);
+    }
+}
+
+
+//
+// R_GrowPool
+// A pool at the top of the arena is grown in place, others are
+//  copied to the top.
+//
+boolean R_GrowPool (renderpool_t* pool)
+{
+    int		oldsize;
+    int		newsize;
+    byte*	top;
+    void*	p;
+
+    if (vanilla_render_limits)
+	return false;
+
+    oldsize = (pool->size * pool->itemsize + 7) & ~7;
+    newsize = pool->size * 2 * pool->itemsize;
+    top = arena + arenatop;
+
+    if ((byte *) pool->base + oldsize == top)
+    {
+	arenatop -= oldsize;
+	p = R_ArenaAlloc (newsize);
+
+	if (p == NULL)
+	{
+	    arenatop += oldsize;
+	    return false;
+	}
+    }
+    else
+    {
+	p = R_ArenaAlloc (newsize);
+
+	if (p == NULL)
+	    return false;
+
+	memcpy (p, pool->base, pool->size * pool->itemsize);
+    }
+
+    pool->base = p;
+    pool->size *= 2;
+
+    return true;
+}
+
+
+//
+// R_NextPoolChunk
+//
+boolean R_NextPoolChunk (renderpool_t* pool)
+{
+    void*	p;
+
+    if (vanilla_render_limits)
+	return false;
+
+    p = R_ArenaAlloc (pool->size * pool->itemsize);
+
+    if (p == NULL)
+	return false;
+
+    pool->base = p;
+
+    return true;
+}
+
+
+//
+// R_PrintArenaStats
+//
+void R_PrintArenaStats (void)
+{
+    renderpool_t*	pool;
+    int			i;
+
+    printf ("render arena: %i of %i KiB used at most\n",
+	    (arenapeak + 1023) / 1024, render_arena_size);
+
+    for (i = 0; i < numpools; i++)
+    {
+	pool = pools[i];
+
+	printf ("%s: %i in the last frame, %i at most (vanilla %i)\n",
+		pool->name, pool->lastused,
+		pool->used > pool->peak ? pool->used : pool->peak,
+		pool->limit);
+    }
+}
@@ -0,0 +1,84 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Per-frame arena for the renderer's visplanes, drawsegs,
+//	 vissprites, openings and solid segs.
+//
+
+
+#ifndef __R_ARENA__
+#define __R_ARENA__
+
+#include "doomtype.h"
+
+//
+// A pool is an array taken from the arena at frame start with room
+//  for the vanilla limit, or for the most entries any frame needed
+//  so far. When full it can be grown, which moves it, unless
+//  vanilla_render_limits is set.
+//
+typedef struct
+{
+    const char*		name;
+    int			itemsize;
+    int			limit;		// vanilla limit
+
+    void*		base;
+    int			size;		// entries allocated this frame
+
+    int			used;		// high-water mark this frame
+    int			lastused;	// high-water mark of the last frame
+    int			peak;		// high-water mark of all frames
+
+} renderpool_t;
+
+// Size of the arena in KiB.
+extern int		render_arena_size;
+
+// If non-zero, the pools do not grow past the vanilla limits.
+extern int		vanilla_render_limits;
+
+void R_InitArena (void);
+
+// Called at frame start, before the pools are cleared.
+void R_ClearArena (void);
+
+// Returns size bytes from the arena for this frame, or NULL.
+void* R_ArenaAlloc (int size);
+
+// Takes a new pool from the arena, with no entries used.
+void R_ResetPool (renderpool_t* pool);
+
+// Doubles a pool. Returns false if it cannot grow; base is only
+//  changed if it returns true.
+boolean R_GrowPool (renderpool_t* pool);
+
+// Takes a fresh array of a pool's size, leaving the old one in
+//  place for pointers into it. Returns false like R_GrowPool.
+boolean R_NextPoolChunk (renderpool_t* pool);
+
+// Prints the high-water marks of all pools.
+void R_PrintArenaStats (void);
+
+//
+// Records that a pool has count entries in use.
+//
+static inline void R_PoolUsed (renderpool_t* pool, int count)
+{
+    if (count > pool->used)
+	pool->used = count;
+}
+
+#endif
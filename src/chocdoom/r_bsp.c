@@ -17,7 +17,7 @@
 //
 
 
-
+#include <string.h>
 
 #include "doomdef.h"
 
@@ -28,6 +28,7 @@
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_things.h"
+#include "r_arena.h"
 
 // State.
 #include "doomstat.h"
@@ -43,9 +44,11 @@ line_t*		linedef;
 sector_t*	frontsector;
 sector_t*	backsector;
 
-drawseg_t	drawsegs[MAXDRAWSEGS];
+drawseg_t*	drawsegs;
 drawseg_t*	ds_p;
 
+renderpool_t	drawsegpool = { "drawsegs", sizeof(drawseg_t), MAXDRAWSEGS };
+
 
 void
 R_StoreWallRange
@@ -60,10 +63,31 @@ R_StoreWallRange
 //
 void R_ClearDrawSegs (void)
 {
+    R_ResetPool (&drawsegpool);
+    drawsegs = drawsegpool.base;
     ds_p = drawsegs;
 }
 
 
+//
+// R_GrowDrawSegs
+//
+boolean R_GrowDrawSegs (void)
+{
+    drawseg_t*	old;
+
+    old = drawsegs;
+
+    if (!R_GrowPool (&drawsegpool))
+	return false;
+
+    drawsegs = drawsegpool.base;
+    ds_p = drawsegs + (ds_p - old);
+
+    return true;
+}
+
+
 
 //
 // ClipWallSegment
@@ -78,11 +102,84 @@ typedef	struct
 } cliprange_t;
 
 
+// The vanilla limit, which vanilla did not check.
 #define MAXSEGS		32
 
 // newend is one past the last valid seg
 cliprange_t*	newend;
-cliprange_t	solidsegs[MAXSEGS];
+cliprange_t*	solidsegs;
+
+static renderpool_t	solidsegpool = { "solidsegs", sizeof(cliprange_t), MAXSEGS };
+
+//
+// Columns covered by solidsegs, one bit per column, and the number
+//  of columns still open. Kept alongside solidsegs, whose ranges
+//  never touch, so a span lies within one range exactly if all
+//  its columns are covered.
+//
+#define COVERWORDS	((SCREENWIDTH + 31) / 32)
+
+static uint32_t		coverage[COVERWORDS];
+static int		opencolumns;
+
+
+//
+// R_MarkCovered
+// Marks the open columns first..last as covered.
+//
+static void
+R_MarkCovered
+( int	first,
+  int	last )
+{
+    uint32_t	mask;
+    int		w;
+
+    opencolumns -= last - first + 1;
+
+    for (w = first >> 5; w <= last >> 5; w++)
+    {
+	mask = ~0u;
+
+	if (w == first >> 5)
+	    mask &= ~0u << (first & 31);
+
+	if (w == last >> 5)
+	    mask &= ~0u >> (31 - (last & 31));
+
+	coverage[w] |= mask;
+    }
+}
+
+
+//
+// R_IsCovered
+// True if all columns first..last are covered.
+//
+static boolean
+R_IsCovered
+( int	first,
+  int	last )
+{
+    uint32_t	mask;
+    int		w;
+
+    for (w = first >> 5; w <= last >> 5; w++)
+    {
+	mask = ~0u;
+
+	if (w == first >> 5)
+	    mask &= ~0u << (first & 31);
+
+	if (w == last >> 5)
+	    mask &= ~0u >> (31 - (last & 31));
+
+	if ((coverage[w] & mask) != mask)
+	    return false;
+    }
+
+    return true;
+}
 
 
 
@@ -100,6 +197,11 @@ R_ClipSolidWallSegment
 {
     cliprange_t*	next;
     cliprange_t*	start;
+    cliprange_t*	old;
+
+    // Hidden behind a single post?
+    if (R_IsCovered (first, last))
+	return;
 
     // Find the first range that touches the range
     //  (adjacent pixels are touching).
@@ -114,6 +216,20 @@ R_ClipSolidWallSegment
 	    // Post is entirely visible (above start),
 	    //  so insert a new clippost.
 	    R_StoreWallRange (first, last);
+	    R_MarkCovered (first, last);
+
+	    if (newend == solidsegs + solidsegpool.size)
+	    {
+		old = solidsegs;
+
+		if (!R_GrowPool (&solidsegpool))
+		    I_Error ("R_ClipSolidWallSegment: solidsegs overflow");
+
+		solidsegs = solidsegpool.base;
+		start = solidsegs + (start - old);
+		newend = solidsegs + (newend - old);
+	    }
+
 	    next = newend;
 	    newend++;
 	    
@@ -124,11 +240,14 @@ R_ClipSolidWallSegment
 	    }
 	    next->first = first;
 	    next->last = last;
+
+	    R_PoolUsed (&solidsegpool, newend - solidsegs);
 	    return;
 	}
 		
 	// There is a fragment above *start.
 	R_StoreWallRange (first, start->first - 1);
+	R_MarkCovered (first, start->first - 1);
 	// Now adjust the clip size.
 	start->first = first;	
     }
@@ -142,6 +261,7 @@ R_ClipSolidWallSegment
     {
 	// There is a fragment between two posts.
 	R_StoreWallRange (next->last + 1, (next+1)->first - 1);
+	R_MarkCovered (next->last + 1, (next+1)->first - 1);
 	next++;
 	
 	if (last <= next->last)
@@ -155,6 +275,7 @@ R_ClipSolidWallSegment
 	
     // There is a fragment after *next.
     R_StoreWallRange (next->last + 1, last);
+    R_MarkCovered (next->last + 1, last);
     // Adjust the clip size.
     start->last = last;
 	
@@ -193,6 +314,10 @@ R_ClipPassWallSegment
 {
     cliprange_t*	start;
 
+    // Hidden behind a single post?
+    if (R_IsCovered (first, last))
+	return;
+
     // Find the first range that touches the range
     //  (adjacent pixels are touching).
     start = solidsegs;
@@ -237,11 +362,17 @@ R_ClipPassWallSegment
 //
 void R_ClearClipSegs (void)
 {
+    R_ResetPool (&solidsegpool);
+    solidsegs = solidsegpool.base;
+
     solidsegs[0].first = -0x7fffffff;
     solidsegs[0].last = -1;
     solidsegs[1].first = viewwidth;
     solidsegs[1].last = 0x7fffffff;
     newend = solidsegs+2;
+
+    memset (coverage, 0, sizeof(coverage));
+    opencolumns = viewwidth;
 }
 
 //
@@ -387,8 +518,6 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     angle_t		span;
     angle_t		tspan;
     
-    cliprange_t*	start;
-
     int			sx1;
     int			sx2;
     
@@ -464,19 +593,10 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     if (sx1 == sx2)
 	return false;			
     sx2--;
-	
-    start = solidsegs;
-    while (start->last < sx2)
-	start++;
-    
-    if (sx1 >= start->first
-	&& sx2 <= start->last)
-    {
-	// The clippost contains the new span.
-	return false;
-    }
 
-    return true;
+    // The clipposts never touch, so one contains the span
+    //  if all its columns are covered.
+    return !R_IsCovered (sx1, sx2);
 }
 
 
@@ -506,6 +626,17 @@ void R_Subsector (int num)
     count = sub->numlines;
     line = &segs[sub->firstline];
 
+    // Once every column is covered, no more walls or planes can be
+    //  seen, but the sprites are still clipped against the drawsegs
+    //  and may show, so the subsector still adds them. With vanilla
+    //  limits the planes are still looked up, as they count towards
+    //  the visplane overflow.
+    if (!opencolumns && !vanilla_render_limits)
+    {
+	R_AddSprites (frontsector);
+	return;
+    }
+
     if (frontsector->floorheight < viewz)
     {
 	floorplane = R_FindPlane (frontsector->floorheight,
@@ -537,37 +668,85 @@ void R_Subsector (int num)
 
 
 
+//
+// Statistics of the current level: BSP nodes visited and back
+//  spaces rejected by R_CheckBBox. Cleared by P_SetupLevel.
+//
+unsigned int		bsp_nodes_visited;
+unsigned int		bsp_bbox_rejects;
+
+// Pending back spaces kept by one R_RenderBSPNode call. Deeper
+//  trees continue in a nested call.
+#define BSPSTACKSIZE	64
+
+
 //
 // RenderBSPNode
-// Renders all subsectors below a given node,
-//  traversing subtree recursively.
+// Renders all subsectors below a given node, front space first.
+// Walks down the front children, keeping each node with the view
+//  side on a stack, then goes back up to the first node whose
+//  back space passes R_CheckBBox. The side of every node is only
+//  computed once.
 // Just call with BSP root.
 void R_RenderBSPNode (int bspnum)
 {
+    node_t*	stack[BSPSTACKSIZE];
+    byte	sides[BSPSTACKSIZE];
+    int		sp;
     node_t*	bsp;
     int		side;
 
-    // Found a subsector?
-    if (bspnum & NF_SUBSECTOR)
+    sp = 0;
+
+    for (;;)
     {
+	// Divide front space down to a subsector.
+	while (!(bspnum & NF_SUBSECTOR))
+	{
+	    if (sp == BSPSTACKSIZE)
+	    {
+		R_RenderBSPNode (bspnum);
+		goto back;
+	    }
+
+	    bsp = &nodes[bspnum];
+	    bsp_nodes_visited++;
+
+	    // Decide which side the view point is on.
+	    side = R_PointOnSide (viewx, viewy, bsp);
+
+	    stack[sp] = bsp;
+	    sides[sp] = side;
+	    sp++;
+
+	    bspnum = bsp->children[side];
+	}
+
 	if (bspnum == -1)			
 	    R_Subsector (0);
 	else
 	    R_Subsector (bspnum&(~NF_SUBSECTOR));
-	return;
-    }
-		
-    bsp = &nodes[bspnum];
-    
-    // Decide which side the view point is on.
-    side = R_PointOnSide (viewx, viewy, bsp);
 
-    // Recursively divide front space.
-    R_RenderBSPNode (bsp->children[side]); 
+      back:
+	// Possibly divide back space.
+	for (;;)
+	{
+	    if (sp == 0)
+		return;
 
-    // Possibly divide back space.
-    if (R_CheckBBox (bsp->bbox[side^1]))	
-	R_RenderBSPNode (bsp->children[side^1]);
+	    sp--;
+	    bsp = stack[sp];
+	    side = sides[sp];
+
+	    if (R_CheckBBox (bsp->bbox[side^1]))
+	    {
+		bspnum = bsp->children[side^1];
+		break;
+	    }
+
+	    bsp_bbox_rejects++;
+	}
+    }
 }
 
 
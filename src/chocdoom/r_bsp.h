@@ -20,6 +20,7 @@
 #ifndef __R_BSP__
 #define __R_BSP__
 
+#include "r_arena.h"
 
 
 extern seg_t*		curline;
@@ -39,9 +40,11 @@ extern boolean		markceiling;
 
 extern boolean		skymap;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
+extern drawseg_t*	drawsegs;
 extern drawseg_t*	ds_p;
 
+extern renderpool_t	drawsegpool;
+
 extern lighttable_t**	hscalelight;
 extern lighttable_t**	vscalelight;
 extern lighttable_t**	dscalelight;
@@ -53,9 +56,13 @@ typedef void (*drawfunc_t) (int start, int stop);
 // BSP?
 void R_ClearClipSegs (void);
 void R_ClearDrawSegs (void);
+boolean R_GrowDrawSegs (void);
 
 
 void R_RenderBSPNode (int bspnum);
 
+extern unsigned int	bsp_nodes_visited;
+extern unsigned int	bsp_bbox_rejects;
+
 
 #endif
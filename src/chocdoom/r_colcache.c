@@ -0,0 +1,196 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Cache of wall texture columns with the light level applied.
+//	The wall drawers read 128 texels of a column, masking the row
+//	 with 127, so a column of a texture at least 128 high is kept
+//	 as 128 lit bytes and drawn without the colormap lookup.
+//	 Entries are found by texture, column and colormap, and the
+//	 least recently used one is replaced on a miss. The cache is
+//	 static in core-coupled RAM, where it fits beside the tables
+//	 of placement.h only up to MAXCOLUMNCACHE KiB.
+//
+
+
+#include <stdio.h>
+
+#include "placement.h"
+
+#include "doomdef.h"
+
+#include "r_local.h"
+#include "r_colcache.h"
+
+
+#define LITCOLUMNHEIGHT		128
+#define MAXLITCOLUMNS		(MAXCOLUMNCACHE*1024/LITCOLUMNHEIGHT)
+#define LITHASHSIZE		(MAXLITCOLUMNS*2)
+
+typedef struct
+{
+    int			key;		// texture << 16 | column, -1 if unused
+    lighttable_t*	colormap;
+    int			hashnext;
+    int			prev;		// in use order, most recent first
+    int			next;
+
+} litcolumn_t;
+
+int			column_cache_size = 0;
+
+unsigned int		column_cache_hits;
+unsigned int		column_cache_misses;
+
+static int		numlitcolumns;
+
+// the entry after the last is the head of the in use order
+static litcolumn_t	litcolumns[MAXLITCOLUMNS+1] LITCOLUMNS_PLACEMENT;
+static int		lithash[LITHASHSIZE] LITCOLUMNS_PLACEMENT;
+static unsigned int	lithashmask;
+
+static byte		litdata[MAXLITCOLUMNS*LITCOLUMNHEIGHT] LITCOLUMNS_PLACEMENT;
+
+#define LITHASH(key, colormap) \
+    ((((key) * 0x9e3779b1u) ^ ((colormap) - colormaps)) & lithashmask)
+
+
+//
+// R_InitColumnCache
+//
+void R_InitColumnCache (void)
+{
+    int		hashsize;
+    int		i;
+
+    numlitcolumns = column_cache_size * 1024 / LITCOLUMNHEIGHT;
+
+    if (numlitcolumns <= 0)
+    {
+	numlitcolumns = 0;
+	return;
+    }
+
+    if (numlitcolumns > MAXLITCOLUMNS)
+	numlitcolumns = MAXLITCOLUMNS;
+
+    // at least two hash chains per entry
+    for (hashsize = 1; hashsize < numlitcolumns * 2; hashsize <<= 1)
+	;
+
+    lithashmask = hashsize - 1;
+
+    for (i = 0; i < numlitcolumns; i++)
+    {
+	litcolumns[i].key = -1;
+	litcolumns[i].prev = i - 1;
+	litcolumns[i].next = i + 1;
+    }
+
+    litcolumns[0].prev = numlitcolumns;
+    litcolumns[numlitcolumns].next = 0;
+    litcolumns[numlitcolumns].prev = numlitcolumns - 1;
+
+    for (i = 0; i < hashsize; i++)
+	lithash[i] = -1;
+}
+
+
+//
+// R_TouchLitColumn
+// Moves an entry to the front of the in use order.
+//
+static void R_TouchLitColumn (int i)
+{
+    litcolumn_t*	lc = &litcolumns[i];
+    litcolumn_t*	head = &litcolumns[numlitcolumns];
+
+    if (head->next == i)
+	return;
+
+    litcolumns[lc->prev].next = lc->next;
+    litcolumns[lc->next].prev = lc->prev;
+
+    lc->prev = numlitcolumns;
+    lc->next = head->next;
+    litcolumns[head->next].prev = i;
+    head->next = i;
+}
+
+
+//
+// R_GetLitColumn
+//
+byte* R_GetLitColumn (int tex, int col, lighttable_t* colormap)
+{
+    litcolumn_t*	lc;
+    byte*		source;
+    byte*		dest;
+    int			key;
+    int			*link;
+    int			i;
+
+    if (!numlitcolumns || textureheight[tex] < (LITCOLUMNHEIGHT << FRACBITS))
+	return NULL;
+
+    key = (tex << 16) | (col & texturewidthmask[tex]);
+
+    for (i = lithash[LITHASH(key, colormap)]; i != -1; i = lc->hashnext)
+    {
+	lc = &litcolumns[i];
+
+	if (lc->key == key && lc->colormap == colormap)
+	{
+	    column_cache_hits++;
+	    R_TouchLitColumn (i);
+	    return litdata + i * LITCOLUMNHEIGHT;
+	}
+    }
+
+    column_cache_misses++;
+
+    // replace the least recently used entry
+    i = litcolumns[numlitcolumns].prev;
+    lc = &litcolumns[i];
+
+    if (lc->key != -1)
+    {
+	for (link = &lithash[LITHASH(lc->key, lc->colormap)];
+	     *link != i;
+	     link = &litcolumns[*link].hashnext)
+	    ;
+
+	*link = lc->hashnext;
+    }
+
+    lc->key = key;
+    lc->colormap = colormap;
+    lc->hashnext = lithash[LITHASH(key, colormap)];
+    lithash[LITHASH(key, colormap)] = i;
+
+    R_TouchLitColumn (i);
+
+    source = R_GetColumn (tex, col);
+    dest = litdata + i * LITCOLUMNHEIGHT;
+
+    for (i = 0; i < LITCOLUMNHEIGHT; i += 4)
+    {
+	dest[i] = colormap[source[i]];
+	dest[i+1] = colormap[source[i+1]];
+	dest[i+2] = colormap[source[i+2]];
+	dest[i+3] = colormap[source[i+3]];
+    }
+
+    return dest;
+}
@@ -0,0 +1,43 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Cache of wall texture columns with the light level applied.
+//
+
+
+#ifndef __R_COLCACHE__
+#define __R_COLCACHE__
+
+#include "r_defs.h"
+
+// Size of the cache in KiB, 0 to turn it off, at most MAXCOLUMNCACHE.
+extern int		column_cache_size;
+
+#define MAXCOLUMNCACHE		4
+
+// Shorter runs of a column are drawn through the colormap, as filling
+//  an entry costs a lookup for each of its 128 texels.
+#define LITCOLUMNMINRUN		32
+
+extern unsigned int	column_cache_hits;
+extern unsigned int	column_cache_misses;
+
+void R_InitColumnCache (void);
+
+// Returns the column with the colormap applied, to be drawn with
+//  identitymap, or NULL if it is not cached.
+byte* R_GetLitColumn (int tex, int col, lighttable_t* colormap);
+
+#endif
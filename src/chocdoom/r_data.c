@@ -19,6 +19,8 @@
 
 #include <stdio.h>
 
+#include "placement.h"
+
 #include "deh_main.h"
 #include "i_swap.h"
 #include "i_system.h"
@@ -162,6 +164,10 @@ fixed_t*	spritetopoffset;
 
 lighttable_t	*colormaps;
 
+// the light tables are read in here when the lump fits,
+//  so the drawers do not look them up in the zone
+static lighttable_t	colormapdata[(NUMCOLORMAPS+2)*256] COLORMAPS_PLACEMENT;
+
 
 //
 // MAPTEXTURE_T CACHING
@@ -689,7 +695,16 @@ void R_InitColormaps (void)
     // Load in the light tables, 
     //  256 byte align tables.
     lump = W_GetNumForName(DEH_String("COLORMAP"));
-    colormaps = W_CacheLumpNum(lump, PU_STATIC);
+
+    if (W_LumpLength(lump) <= sizeof(colormapdata))
+    {
+	W_ReadLump(lump, colormapdata);
+	colormaps = colormapdata;
+    }
+    else
+    {
+	colormaps = W_CacheLumpNum(lump, PU_STATIC);
+    }
 }
 
 
@@ -427,6 +427,9 @@ typedef struct
   int			lightlevel;
   int			minx;
   int			maxx;
+
+  // next plane in the R_FindPlane hash chain, or -1
+  int			next;
   
   // leave pads for [minx-1]/[maxx+1]
   
@@ -21,10 +21,13 @@
 
 
 
+#include "placement.h"
+
 #include "doomdef.h"
 #include "deh_main.h"
 
 #include "i_system.h"
+#include "i_timer.h"
 #include "z_zone.h"
 #include "w_wad.h"
 
@@ -60,8 +63,8 @@ int		scaledviewwidth;
 int		viewheight;
 int		viewwindowx;
 int		viewwindowy; 
-byte*		ylookup[MAXHEIGHT]; 
-int		columnofs[MAXWIDTH]; 
+byte*		ylookup[MAXHEIGHT] YLOOKUP_PLACEMENT;
+int		columnofs[MAXWIDTH] COLUMNOFS_PLACEMENT;
 
 // Color tables for different players,
 //  translate a limited part to another
@@ -92,14 +95,29 @@ byte*			dc_source;
 // just for profiling 
 int			dccount;
 
+// If non-zero, R_Init checks the column drawers against the reference
+// drawer on every wall texture column and prints the cycles of both.
+
+int			draw_column_check = 0;
+
+// A colormap that maps every color to itself: the fullbright map
+//  if it does, else identitytable. R_DrawColumn skips it.
+
+lighttable_t*		identitymap;
+
+static lighttable_t	identitytable[256];
+
 //
 // A column is a vertical slice/span from a wall texture that,
 //  given the DOOM style restrictions on the view orientation,
 //  will always have constant z depth.
 // Thus a special case loop for very fast rendering can
 //  be used. It has also been used with Wolfenstein 3D.
+//
+// This is the original drawer, kept as the reference for the
+//  specialized ones below.
 // 
-void R_DrawColumn (void) 
+static void R_DrawColumnReference (void) 
 { 
     int			count; 
     byte*		dest; 
@@ -112,13 +130,6 @@ void R_DrawColumn (void)
     if (count < 0) 
 	return; 
 				 
-#ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
-	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT) 
-	I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x); 
-#endif 
-
     // Framebuffer destination address.
     // Use ylookup LUT to avoid multiply with ScreenWidth.
     // Use columnofs LUT for subwindows? 
@@ -131,78 +142,201 @@ void R_DrawColumn (void)
 
     // Inner loop that does the actual texture mapping,
     //  e.g. a DDA-lile scaling.
-    // This is as fast as it gets.
     do 
     {
 	// Re-map color indices from wall texture column
 	//  using a lighting/special effects LUT.
 	*dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
 	
-	dest += SCREENWIDTH; 
+	dest += SCREENYSTEP; 
 	frac += fracstep;
 	
     } while (count--); 
 } 
 
+//
+// Column drawer core, 8x unrolled with all state in registers.
+// Texture rows wrap at 128 like in the reference drawer, unless the
+//  caller knows the column stays within the first 128 rows. The
+//  colormap lookup is left out for the identity map.
+// Runs shorter than 8 pixels only take the tail loop.
+//
+#define COLUMN_TEXEL(f) \
+    (wrap ? source[((f)>>FRACBITS)&127] : source[(f)>>FRACBITS])
+#define COLUMN_PIXEL(f) \
+    (identity ? COLUMN_TEXEL(f) : colormap[COLUMN_TEXEL(f)])
+
+static inline void
+R_DrawColumnCore
+( byte*		dest,
+  const byte*	source,
+  const byte*	colormap,
+  fixed_t	frac,
+  fixed_t	fracstep,
+  int		count,
+  boolean	wrap,
+  boolean	identity )
+{
+    while (count >= 8)
+    {
+	dest[0] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP*2] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP*3] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP*4] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP*5] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP*6] = COLUMN_PIXEL(frac); frac += fracstep;
+	dest[SCREENYSTEP*7] = COLUMN_PIXEL(frac); frac += fracstep;
+
+	dest += SCREENYSTEP*8;
+	count -= 8;
+    }
 
+    while (count > 0)
+    {
+	*dest = COLUMN_PIXEL(frac);
+	dest += SCREENYSTEP;
+	frac += fracstep;
+	count--;
+    }
+}
 
-// UNUSED.
-// Loop unrolled.
-#if 0
+//
+// R_DrawColumn
+// Selects the specialized core for this column: without the
+//  wrap-around mask if all rows drawn lie within the first 128
+//  texture rows, and without the colormap for the identity map.
+//
 void R_DrawColumn (void) 
 { 
     int			count; 
-    byte*		source;
-    byte*		dest;
-    byte*		colormap;
-    
-    unsigned		frac;
-    unsigned		fracstep;
-    unsigned		fracstep2;
-    unsigned		fracstep3;
-    unsigned		fracstep4;	 
+    byte*		dest; 
+    fixed_t		frac;
+    fixed_t		fracstep;	 
+    boolean		wrap;
  
     count = dc_yh - dc_yl + 1; 
 
-    source = dc_source;
-    colormap = dc_colormap;		 
+    // Zero length, column does not exceed a pixel.
+    if (count <= 0) 
+	return; 
+				 
+#ifdef RANGECHECK 
+    if ((unsigned)dc_x >= SCREENWIDTH
+	|| dc_yl < 0
+	|| dc_yh >= SCREENHEIGHT) 
+	I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x); 
+#endif 
+
     dest = ylookup[dc_yl] + columnofs[dc_x];  
-	 
-    fracstep = dc_iscale<<9; 
-    frac = (dc_texturemid + (dc_yl-centery)*dc_iscale)<<9; 
- 
-    fracstep2 = fracstep+fracstep;
-    fracstep3 = fracstep2+fracstep;
-    fracstep4 = fracstep3+fracstep;
-	
-    while (count >= 8) 
-    { 
-	dest[0] = colormap[source[frac>>25]]; 
-	dest[SCREENWIDTH] = colormap[source[(frac+fracstep)>>25]]; 
-	dest[SCREENWIDTH*2] = colormap[source[(frac+fracstep2)>>25]]; 
-	dest[SCREENWIDTH*3] = colormap[source[(frac+fracstep3)>>25]];
-	
-	frac += fracstep4; 
 
-	dest[SCREENWIDTH*4] = colormap[source[frac>>25]]; 
-	dest[SCREENWIDTH*5] = colormap[source[(frac+fracstep)>>25]]; 
-	dest[SCREENWIDTH*6] = colormap[source[(frac+fracstep2)>>25]]; 
-	dest[SCREENWIDTH*7] = colormap[source[(frac+fracstep3)>>25]]; 
+    fracstep = dc_iscale; 
+    frac = dc_texturemid + (dc_yl-centery)*fracstep; 
+
+    wrap = frac < 0
+        || (int64_t) frac + (int64_t) (count - 1) * fracstep >= (128 << FRACBITS);
 
-	frac += fracstep4; 
-	dest += SCREENWIDTH*8; 
-	count -= 8;
-    } 
-	
-    while (count > 0)
-    { 
-	*dest = colormap[source[frac>>25]]; 
-	dest += SCREENWIDTH; 
-	frac += fracstep; 
-	count--;
-    } 
+    if (dc_colormap == identitymap)
+    {
+	if (wrap)
+	    R_DrawColumnCore(dest, dc_source, NULL, frac, fracstep, count, true, true);
+	else
+	    R_DrawColumnCore(dest, dc_source, NULL, frac, fracstep, count, false, true);
+    }
+    else
+    {
+	if (wrap)
+	    R_DrawColumnCore(dest, dc_source, dc_colormap, frac, fracstep, count, true, false);
+	else
+	    R_DrawColumnCore(dest, dc_source, dc_colormap, frac, fracstep, count, false, false);
+    }
+} 
+
+
+//
+// R_CheckColumnDrawers
+// Draws every column of every wall texture at several scales, offsets
+//  and light levels with both R_DrawColumn and the reference drawer
+//  into a scratch screen, and reports differing pixels and cycles.
+//
+static void R_CheckColumnDrawers (void)
+{
+    static const fixed_t iscales[] =
+    {
+	FRACUNIT/4, FRACUNIT/2 + 123, FRACUNIT, 3*FRACUNIT/2 + 77, 5*FRACUNIT
+    };
+    static const fixed_t texturemids[] =
+    {
+	0, 100*FRACUNIT + 0x8000, -37*FRACUNIT
+    };
+    byte*		saved_ylookup[SCREENHEIGHT];
+    int			saved_columnofs[2];
+    byte*		screen;
+    unsigned int	ref_cycles, cycles, start;
+    int			mismatches;
+    int			tex, col, i, j, k, y;
+
+    memcpy(saved_ylookup, ylookup, sizeof(saved_ylookup));
+    memcpy(saved_columnofs, columnofs, sizeof(saved_columnofs));
+
+    screen = Z_Malloc(SCREENAREA(SCREENHEIGHT), PU_STATIC, NULL);
+
+    for (y = 0; y < SCREENHEIGHT; y++)
+	ylookup[y] = screen + y*SCREENYSTEP;
+
+    columnofs[0] = 0;
+    columnofs[1] = SCREENXSTEP;
+
+    ref_cycles = cycles = 0;
+    mismatches = 0;
+
+    for (tex = 0; tex < numtextures; tex++)
+    {
+	for (col = 0; col <= texturewidthmask[tex]; col++)
+	{
+	    dc_source = R_GetColumn(tex, col);
+
+	    for (i = 0; i < arrlen(iscales); i++)
+	    {
+		for (j = 0; j < arrlen(texturemids); j++)
+		{
+		    for (k = 0; k < 2; k++)
+		    {
+			dc_iscale = iscales[i];
+			dc_texturemid = texturemids[j];
+			dc_colormap = colormaps + k*20*256;
+			dc_yl = (i + j) % 3;
+			dc_yh = SCREENHEIGHT - 1 - k*7;
+
+			dc_x = 0;
+			start = I_GetCycles();
+			R_DrawColumnReference();
+			ref_cycles += I_GetCycles() - start;
+
+			dc_x = 1;
+			start = I_GetCycles();
+			R_DrawColumn();
+			cycles += I_GetCycles() - start;
+
+			for (y = dc_yl; y <= dc_yh; y++)
+			{
+			    if (ylookup[y][columnofs[0]] != ylookup[y][columnofs[1]])
+				mismatches++;
+			}
+		    }
+		}
+	    }
+	}
+    }
+
+    printf("R_CheckColumnDrawers: %u cycles, reference: %u cycles, "
+           "%d pixels differ\n", cycles, ref_cycles, mismatches);
+
+    Z_Free(screen);
+
+    memcpy(ylookup, saved_ylookup, sizeof(saved_ylookup));
+    memcpy(columnofs, saved_columnofs, sizeof(saved_columnofs));
 }
-#endif
 
 
 void R_DrawColumnLow (void) 
@@ -243,8 +377,8 @@ void R_DrawColumnLow (void)
     {
 	// Hack. Does not work corretly.
 	*dest2 = *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += SCREENYSTEP;
+	dest2 += SCREENYSTEP;
 	frac += fracstep; 
 
     } while (count--);
@@ -255,7 +389,7 @@ void R_DrawColumnLow (void)
 // Spectre/Invisibility.
 //
 #define FUZZTABLE		50 
-#define FUZZOFF	(SCREENWIDTH)
+#define FUZZOFF	(SCREENYSTEP)
 
 
 int	fuzzoffset[FUZZTABLE] =
@@ -331,7 +465,7 @@ void R_DrawFuzzColumn (void)
 	if (++fuzzpos == FUZZTABLE) 
 	    fuzzpos = 0;
 	
-	dest += SCREENWIDTH;
+	dest += SCREENYSTEP;
 
 	frac += fracstep; 
     } while (count--); 
@@ -398,8 +532,8 @@ void R_DrawFuzzColumnLow (void)
 	if (++fuzzpos == FUZZTABLE) 
 	    fuzzpos = 0;
 	
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += SCREENYSTEP;
+	dest2 += SCREENYSTEP;
 
 	frac += fracstep; 
     } while (count--); 
@@ -459,7 +593,7 @@ void R_DrawTranslatedColumn (void)
 	// Thus the "green" ramp of the player 0 sprite
 	//  is mapped to gray, red, black/indigo. 
 	*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
+	dest += SCREENYSTEP;
 	
 	frac += fracstep; 
     } while (count--); 
@@ -510,8 +644,8 @@ void R_DrawTranslatedColumnLow (void)
 	//  is mapped to gray, red, black/indigo. 
 	*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
 	*dest2 = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += SCREENYSTEP;
+	dest2 += SCREENYSTEP;
 	
 	frac += fracstep; 
     } while (count--); 
@@ -585,9 +719,29 @@ byte*			ds_source;
 int			dscount;
 
 
+// If non-zero, R_Init checks the span drawers against the reference
+// drawers on every flat and prints the cycles of both.
+
+int			draw_span_check = 0;
+
 //
-// Draws the actual span.
-void R_DrawSpan (void) 
+// Pack position and step variables into a single 32-bit integer,
+//  with x in the top 16 bits and y in the bottom 16 bits. For
+//  each 16-bit part, the top 6 bits are the integer part and the
+//  bottom 10 bits are the fractional part of the pixel position.
+//
+#define SPAN_PACK(x, y) \
+    ((((x) << 10) & 0xffff0000) | (((y) >> 6) & 0x0000ffff))
+
+// Texture index in the 64x64 flat of a packed position.
+
+#define SPAN_SPOT(p)	((((p) >> 4) & 0x0fc0) | ((p) >> 26))
+
+//
+// These are the original drawers, kept as the reference for the
+//  packed ones below.
+//
+static void R_DrawSpanReference (void) 
 { 
     unsigned int position, step;
     byte *dest;
@@ -595,27 +749,8 @@ void R_DrawSpan (void)
     int spot;
     unsigned int xtemp, ytemp;
 
-#ifdef RANGECHECK
-    if (ds_x2 < ds_x1
-	|| ds_x1<0
-	|| ds_x2>=SCREENWIDTH
-	|| (unsigned)ds_y>SCREENHEIGHT)
-    {
-	I_Error( "R_DrawSpan: %i to %i at %i",
-		 ds_x1,ds_x2,ds_y);
-    }
-//	dscount++;
-#endif
-
-    // Pack position and step variables into a single 32-bit integer,
-    // with x in the top 16 bits and y in the bottom 16 bits.  For
-    // each 16-bit part, the top 6 bits are the integer part and the
-    // bottom 10 bits are the fractional part of the pixel position.
-
-    position = ((ds_xfrac << 10) & 0xffff0000)
-             | ((ds_yfrac >> 6)  & 0x0000ffff);
-    step = ((ds_xstep << 10) & 0xffff0000)
-         | ((ds_ystep >> 6)  & 0x0000ffff);
+    position = SPAN_PACK(ds_xfrac, ds_yfrac);
+    step = SPAN_PACK(ds_xstep, ds_ystep);
 
     dest = ylookup[ds_y] + columnofs[ds_x1];
 
@@ -631,98 +766,150 @@ void R_DrawSpan (void)
 
 	// Lookup pixel from flat texture tile,
 	//  re-index using light/colormap.
-	*dest++ = ds_colormap[ds_source[spot]];
+	*dest = ds_colormap[ds_source[spot]];
+	dest += SCREENXSTEP;
 
         position += step;
 
     } while (count--);
 }
 
+static void R_DrawSpanLowReference (void)
+{
+    unsigned int position, step;
+    unsigned int xtemp, ytemp;
+    byte *dest;
+    int count;
+    int spot;
+
+    position = SPAN_PACK(ds_xfrac, ds_yfrac);
+    step = SPAN_PACK(ds_xstep, ds_ystep);
+
+    count = (ds_x2 - ds_x1);
 
+    dest = ylookup[ds_y] + columnofs[ds_x1 << 1];
 
-// UNUSED.
-// Loop unrolled by 4.
-#if 0
+    do
+    {
+	// Calculate current texture index in u,v.
+        ytemp = (position >> 4) & 0x0fc0;
+        xtemp = (position >> 26);
+        spot = xtemp | ytemp;
+
+	// Lowres/blocky mode does it twice,
+	//  while scale is adjusted appropriately.
+	dest[0] = ds_colormap[ds_source[spot]];
+	dest[SCREENXSTEP] = ds_colormap[ds_source[spot]];
+	dest += 2 * SCREENXSTEP;
+
+	position += step;
+
+    } while (count--);
+}
+
+//
+// R_DrawSpan
+// Draws the actual span. In the row-major layout the pixels of
+//  a span are adjacent, so after a head up to the next word
+//  boundary four pixels are assembled and written with one
+//  aligned 32-bit store (little-endian, like the target).
+// The column-major layout falls back to 4x unrolled byte stores.
+//
 void R_DrawSpan (void) 
 { 
-    unsigned	position, step;
+    unsigned int	position, step;
+    const byte*		source;
+    const byte*		colormap;
+    byte*		dest;
+    int			count;
+
+#ifdef RANGECHECK
+    if (ds_x2 < ds_x1
+	|| ds_x1<0
+	|| ds_x2>=SCREENWIDTH
+	|| (unsigned)ds_y>SCREENHEIGHT)
+    {
+	I_Error( "R_DrawSpan: %i to %i at %i",
+		 ds_x1,ds_x2,ds_y);
+    }
+#endif
+
+    position = SPAN_PACK(ds_xfrac, ds_yfrac);
+    step = SPAN_PACK(ds_xstep, ds_ystep);
 
-    byte*	source;
-    byte*	colormap;
-    byte*	dest;
-    
-    unsigned	count;
-    usingned	spot; 
-    unsigned	value;
-    unsigned	temp;
-    unsigned	xtemp;
-    unsigned	ytemp;
-		
-    position = ((ds_xfrac<<10)&0xffff0000) | ((ds_yfrac>>6)&0xffff);
-    step = ((ds_xstep<<10)&0xffff0000) | ((ds_ystep>>6)&0xffff);
-		
     source = ds_source;
     colormap = ds_colormap;
-    dest = ylookup[ds_y] + columnofs[ds_x1];	 
-    count = ds_x2 - ds_x1 + 1; 
-	
-    while (count >= 4) 
-    { 
-	ytemp = position>>4;
-	ytemp = ytemp & 4032;
-	xtemp = position>>26;
-	spot = xtemp | ytemp;
-	position += step;
-	dest[0] = colormap[source[spot]]; 
+    dest = ylookup[ds_y] + columnofs[ds_x1];
+    count = ds_x2 - ds_x1 + 1;
 
-	ytemp = position>>4;
-	ytemp = ytemp & 4032;
-	xtemp = position>>26;
-	spot = xtemp | ytemp;
+#ifdef FEATURE_COLUMN_MAJOR
+    while (count >= 4)
+    {
+	dest[0] = colormap[source[SPAN_SPOT(position)]];
 	position += step;
-	dest[1] = colormap[source[spot]];
-	
-	ytemp = position>>4;
-	ytemp = ytemp & 4032;
-	xtemp = position>>26;
-	spot = xtemp | ytemp;
+	dest[SCREENXSTEP] = colormap[source[SPAN_SPOT(position)]];
 	position += step;
-	dest[2] = colormap[source[spot]];
-	
-	ytemp = position>>4;
-	ytemp = ytemp & 4032;
-	xtemp = position>>26;
-	spot = xtemp | ytemp;
+	dest[SCREENXSTEP*2] = colormap[source[SPAN_SPOT(position)]];
 	position += step;
-	dest[3] = colormap[source[spot]]; 
-		
+	dest[SCREENXSTEP*3] = colormap[source[SPAN_SPOT(position)]];
+	position += step;
+
+	dest += SCREENXSTEP*4;
 	count -= 4;
-	dest += 4;
-    } 
-    while (count > 0) 
-    { 
-	ytemp = position>>4;
-	ytemp = ytemp & 4032;
-	xtemp = position>>26;
-	spot = xtemp | ytemp;
+    }
+#else
+    // Head up to the first word boundary.
+    while (((uintptr_t) dest & 3) != 0 && count > 0)
+    {
+	*dest++ = colormap[source[SPAN_SPOT(position)]];
 	position += step;
-	*dest++ = colormap[source[spot]]; 
 	count--;
-    } 
-} 
+    }
+
+    while (count >= 4)
+    {
+	uint32_t	pixels;
+
+	pixels = colormap[source[SPAN_SPOT(position)]];
+	position += step;
+	pixels |= colormap[source[SPAN_SPOT(position)]] << 8;
+	position += step;
+	pixels |= colormap[source[SPAN_SPOT(position)]] << 16;
+	position += step;
+	pixels |= (uint32_t) colormap[source[SPAN_SPOT(position)]] << 24;
+	position += step;
+
+	*(uint32_t *) dest = pixels;
+	dest += 4;
+	count -= 4;
+    }
 #endif
 
+    // Tail.
+    while (count > 0)
+    {
+	*dest = colormap[source[SPAN_SPOT(position)]];
+	dest += SCREENXSTEP;
+	position += step;
+	count--;
+    }
+}
+
 
 //
 // Again..
+// Each texel covers two pixels, so one 32-bit store takes two
+//  texels. Unlike the original drawer, ds_x1 and ds_x2 are left
+//  unchanged.
 //
 void R_DrawSpanLow (void)
 {
-    unsigned int position, step;
-    unsigned int xtemp, ytemp;
-    byte *dest;
-    int count;
-    int spot;
+    unsigned int	position, step;
+    const byte*		source;
+    const byte*		colormap;
+    byte*		dest;
+    int			count;
+    byte		pixel;
 
 #ifdef RANGECHECK
     if (ds_x2 < ds_x1
@@ -733,37 +920,213 @@ void R_DrawSpanLow (void)
 	I_Error( "R_DrawSpan: %i to %i at %i",
 		 ds_x1,ds_x2,ds_y);
     }
-//	dscount++; 
 #endif
 
-    position = ((ds_xfrac << 10) & 0xffff0000)
-             | ((ds_yfrac >> 6)  & 0x0000ffff);
-    step = ((ds_xstep << 10) & 0xffff0000)
-         | ((ds_ystep >> 6)  & 0x0000ffff);
+    position = SPAN_PACK(ds_xfrac, ds_yfrac);
+    step = SPAN_PACK(ds_xstep, ds_ystep);
 
-    count = (ds_x2 - ds_x1);
+    source = ds_source;
+    colormap = ds_colormap;
 
     // Blocky mode, need to multiply by 2.
-    ds_x1 <<= 1;
-    ds_x2 <<= 1;
+    dest = ylookup[ds_y] + columnofs[ds_x1 << 1];
+    count = ds_x2 - ds_x1 + 1;
 
-    dest = ylookup[ds_y] + columnofs[ds_x1];
+#ifdef FEATURE_COLUMN_MAJOR
+    while (count >= 2)
+    {
+	pixel = colormap[source[SPAN_SPOT(position)]];
+	position += step;
+	dest[0] = pixel;
+	dest[SCREENXSTEP] = pixel;
+	pixel = colormap[source[SPAN_SPOT(position)]];
+	position += step;
+	dest[SCREENXSTEP*2] = pixel;
+	dest[SCREENXSTEP*3] = pixel;
 
-    do
+	dest += SCREENXSTEP*4;
+	count -= 2;
+    }
+#else
+    // Head up to the first word boundary.
+    while (((uintptr_t) dest & 3) != 0 && count > 0)
     {
-	// Calculate current texture index in u,v.
-        ytemp = (position >> 4) & 0x0fc0;
-        xtemp = (position >> 26);
-        spot = xtemp | ytemp;
+	pixel = colormap[source[SPAN_SPOT(position)]];
+	position += step;
+	dest[0] = pixel;
+	dest[1] = pixel;
+	dest += 2;
+	count--;
+    }
 
-	// Lowres/blocky mode does it twice,
-	//  while scale is adjusted appropriately.
-	*dest++ = ds_colormap[ds_source[spot]];
-	*dest++ = ds_colormap[ds_source[spot]];
+    while (count >= 2)
+    {
+	uint32_t	pixels;
 
+	pixels = colormap[source[SPAN_SPOT(position)]] * 0x0101;
+	position += step;
+	pixels |= (uint32_t) colormap[source[SPAN_SPOT(position)]] * 0x01010000;
 	position += step;
 
-    } while (count--);
+	*(uint32_t *) dest = pixels;
+	dest += 4;
+	count -= 2;
+    }
+#endif
+
+    // Tail.
+    while (count > 0)
+    {
+	pixel = colormap[source[SPAN_SPOT(position)]];
+	position += step;
+	dest[0] = pixel;
+	dest[SCREENXSTEP] = pixel;
+	dest += 2 * SCREENXSTEP;
+	count--;
+    }
+}
+
+
+//
+// R_CheckSpanDrawers
+// Draws spans of every flat at several positions, steps, lengths
+//  and light levels with both the packed and the reference span
+//  drawers into a scratch screen, and reports differing pixels
+//  and cycles.
+//
+static void R_CheckSpanDrawers (void)
+{
+    static const fixed_t steps[][2] =
+    {
+	{ FRACUNIT, 0 },
+	{ FRACUNIT/3, -FRACUNIT/7 },
+	{ -5*FRACUNIT/4, 2*FRACUNIT + 99 },
+	{ 7*FRACUNIT, 3*FRACUNIT/5 }
+    };
+    static const fixed_t fracs[][2] =
+    {
+	{ 0, 0 },
+	{ 1000*FRACUNIT + 0x1234, -333*FRACUNIT - 0x4321 }
+    };
+    static const int lengths[] =
+    {
+	1, 2, 3, 4, 5, 7, 13, 64, SCREENWIDTH/2 - 8
+    };
+    byte*		saved_ylookup[4];
+    int			saved_columnofs[SCREENWIDTH];
+    byte*		screen;
+    unsigned int	ref_cycles, cycles, start;
+    int			mismatches;
+    int			flat, i, j, k, len, x1, width, low, x;
+
+    memcpy(saved_ylookup, ylookup, sizeof(saved_ylookup));
+    memcpy(saved_columnofs, columnofs, sizeof(saved_columnofs));
+
+    screen = Z_Malloc(SCREENAREA(4), PU_STATIC, NULL);
+
+    for (i = 0; i < 4; i++)
+	ylookup[i] = screen + i*SCREENYSTEP;
+
+    for (x = 0; x < SCREENWIDTH; x++)
+	columnofs[x] = x*SCREENXSTEP;
+
+    ref_cycles = cycles = 0;
+    mismatches = 0;
+
+    for (flat = 0; flat < numflats; flat++)
+    {
+	ds_source = W_CacheLumpNum(firstflat + flat, PU_STATIC);
+
+	for (i = 0; i < arrlen(steps); i++)
+	{
+	    for (j = 0; j < arrlen(fracs); j++)
+	    {
+		for (len = 0; len < arrlen(lengths); len++)
+		{
+		    for (k = 0; k < 4; k++)
+		    {
+			// Start at each offset to a word boundary.
+			x1 = k + (i + j) % 2 * 4;
+			low = (len + k) % 2;
+
+			ds_xstep = steps[i][0];
+			ds_ystep = steps[i][1];
+			ds_xfrac = fracs[j][0] + k*FRACUNIT/3;
+			ds_yfrac = fracs[j][1];
+			ds_colormap = colormaps + k*8*256;
+			ds_x1 = x1;
+			ds_x2 = x1 + lengths[len] - 1;
+
+			ds_y = 0;
+			start = I_GetCycles();
+			if (low)
+			    R_DrawSpanLowReference();
+			else
+			    R_DrawSpanReference();
+			ref_cycles += I_GetCycles() - start;
+
+			ds_y = 1;
+			start = I_GetCycles();
+			if (low)
+			    R_DrawSpanLow();
+			else
+			    R_DrawSpan();
+			cycles += I_GetCycles() - start;
+
+			if (low)
+			{
+			    x1 <<= 1;
+			    width = lengths[len] * 2;
+			}
+			else
+			{
+			    width = lengths[len];
+			}
+
+			for (x = x1; x < x1 + width; x++)
+			{
+			    if (ylookup[0][columnofs[x]] != ylookup[1][columnofs[x]])
+				mismatches++;
+			}
+		    }
+		}
+	    }
+	}
+
+	W_ReleaseLumpNum(firstflat + flat);
+    }
+
+    printf("R_CheckSpanDrawers: %u cycles, reference: %u cycles, "
+           "%d pixels differ\n", cycles, ref_cycles, mismatches);
+
+    Z_Free(screen);
+
+    memcpy(ylookup, saved_ylookup, sizeof(saved_ylookup));
+    memcpy(columnofs, saved_columnofs, sizeof(saved_columnofs));
+}
+
+//
+// R_InitDrawers
+//
+void R_InitDrawers (void)
+{
+    int			i;
+
+    identitymap = colormaps;
+
+    for (i = 0; i < 256; i++)
+    {
+	identitytable[i] = i;
+
+	if (colormaps[i] != i)
+	    identitymap = identitytable;
+    }
+
+    if (draw_column_check)
+	R_CheckColumnDrawers();
+
+    if (draw_span_check)
+	R_CheckSpanDrawers();
 }
 
 //
@@ -787,7 +1150,7 @@ R_InitBuffer
 
     // Column offset. For windows.
     for (i=0 ; i<width ; i++) 
-	columnofs[i] = viewwindowx + i;
+	columnofs[i] = (viewwindowx + i) * SCREENXSTEP;
 
     // Samw with base row offset.
     if (width == SCREENWIDTH) 
@@ -797,7 +1160,7 @@ R_InitBuffer
 
     // Preclaculate all row offsets.
     for (i=0 ; i<height ; i++) 
-	ylookup[i] = I_VideoBuffer + (i+viewwindowy)*SCREENWIDTH; 
+	ylookup[i] = I_VideoBuffer + (i+viewwindowy)*SCREENYSTEP; 
 } 
  
  
@@ -843,7 +1206,7 @@ void R_FillBackScreen (void)
 	
     if (background_buffer == NULL)
     {
-        background_buffer = Z_Malloc(SCREENWIDTH * (SCREENHEIGHT - SBARHEIGHT),
+        background_buffer = Z_Malloc(SCREENAREA(SCREENHEIGHT - SBARHEIGHT),
                                      PU_STATIC, NULL);
     }
 
@@ -854,7 +1217,16 @@ void R_FillBackScreen (void)
     
     src = W_CacheLumpName(name, PU_CACHE); 
     dest = background_buffer;
-	 
+
+#ifdef FEATURE_COLUMN_MAJOR
+    for (x=0 ; x<SCREENWIDTH ; x++)
+    {
+	dest = background_buffer + x*SCREENXSTEP;
+
+	for (y=0 ; y<SCREENHEIGHT-SBARHEIGHT ; y++)
+	    *dest++ = src[((y&63)<<6) + (x&63)];
+    }
+#else
     for (y=0 ; y<SCREENHEIGHT-SBARHEIGHT ; y++) 
     { 
 	for (x=0 ; x<SCREENWIDTH/64 ; x++) 
@@ -869,6 +1241,7 @@ void R_FillBackScreen (void)
 	    dest += (SCREENWIDTH&63); 
 	} 
     } 
+#endif
      
     // Draw screen and bezel; this is done to a separate screen buffer.
 
@@ -920,6 +1293,10 @@ R_VideoErase
 ( unsigned	ofs,
   int		count ) 
 { 
+#ifdef FEATURE_COLUMN_MAJOR
+    int		x, y, n;
+#endif
+
   // LFB copy.
   // This might not be a good idea if memcpy
   //  is not optiomal, e.g. byte by byte on
@@ -928,7 +1305,31 @@ R_VideoErase
 
     if (background_buffer != NULL)
     {
+        // mark the whole lines touched, for the dirty area scanout
+        V_MarkRect (0, ofs / SCREENWIDTH, SCREENWIDTH,
+                    (ofs + count - 1) / SCREENWIDTH - ofs / SCREENWIDTH + 1);
+
+#ifdef FEATURE_COLUMN_MAJOR
+        // ofs and count are linear row-major positions; copy them
+        // one row segment at a time
+        while (count > 0)
+        {
+            x = ofs % SCREENWIDTH;
+            y = ofs / SCREENWIDTH;
+            n = SCREENWIDTH - x;
+
+            if (n > count)
+                n = count;
+
+            ofs += n;
+            count -= n;
+
+            for ( ; n > 0; n--, x++)
+                I_VideoBuffer[SCREENOFS(x, y)] = background_buffer[SCREENOFS(x, y)];
+        }
+#else
         memcpy(I_VideoBuffer + ofs, background_buffer + ofs, count); 
+#endif
     }
 } 
 
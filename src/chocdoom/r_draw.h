@@ -33,6 +33,9 @@ extern fixed_t		dc_texturemid;
 // first pixel in a column
 extern byte*		dc_source;		
 
+// Maps every color to itself, set by R_InitDrawers.
+extern lighttable_t*	identitymap;
+
 
 // The span blitting interface.
 // Hook in assembler or system specific BLT
@@ -40,6 +43,12 @@ extern byte*		dc_source;
 void 	R_DrawColumn (void);
 void 	R_DrawColumnLow (void);
 
+// Set up the specialized drawers, after the colormaps are loaded.
+void	R_InitDrawers (void);
+
+extern int		draw_column_check;
+extern int		draw_span_check;
+
 // The Spectre/Invisibility effect.
 void 	R_DrawFuzzColumn (void);
 void 	R_DrawFuzzColumnLow (void);
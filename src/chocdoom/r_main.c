@@ -26,14 +26,20 @@
 #include <math.h>
 
 
+#include "placement.h"
+
 #include "doomdef.h"
 #include "d_loop.h"
 
 #include "m_bbox.h"
 #include "m_menu.h"
 
+#include "i_timer.h"
+
 #include "r_local.h"
+#include "r_colcache.h"
 #include "r_sky.h"
+#include "v_video.h"
 
 
 
@@ -90,12 +96,12 @@ angle_t			clipangle;
 // maps the visible view angles to screen X coordinates,
 // flattening the arc to a flat projection plane.
 // There will be many angles mapped to the same X. 
-int			viewangletox[FINEANGLES/2];
+int			viewangletox[FINEANGLES/2] VIEWANGLETOX_PLACEMENT;
 
 // The xtoviewangleangle[] table maps a screen pixel
 // to the lowest viewangle that maps back to x ranges
 // from clipangle to -clipangle.
-angle_t			xtoviewangle[SCREENWIDTH+1];
+angle_t			xtoviewangle[SCREENWIDTH+1] XTOVIEWANGLE_PLACEMENT;
 
 lighttable_t*		scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
 lighttable_t*		scalelightfixed[MAXLIGHTSCALE];
@@ -776,11 +782,14 @@ void R_Init (void)
 
     R_SetViewSize (screenblocks, detailLevel);
     R_InitPlanes ();
+    R_InitArena ();
     printf (".");
     R_InitLightTables ();
     printf (".");
     R_InitSkyMap ();
     R_InitTranslationTables ();
+    R_InitDrawers ();
+    R_InitColumnCache ();
     printf (".");
 	
     framecount = 0;
@@ -857,14 +866,128 @@ void R_SetupFrame (player_t* player)
 
 
 
+//
+// Frame-time budget.
+// While the average render time is over frame_budget, the view
+//  drops to low detail and then to smaller sizes, one step at a
+//  time. It goes back up once the average is frame_budget_hysteresis
+//  percent under the budget. Going down again right after going up
+//  doubles the wait before the next step up, so it does not flip
+//  between two steps. The player's screenblocks and detailLevel are
+//  the best it uses.
+//
+#define BUDGETHOLD		35	// frames between steps
+#define BUDGETMAXBACKOFF	16
+#define BUDGETMINBLOCKS		3
+
+int		frame_budget = 0;
+int		frame_budget_hysteresis = 40;
+
+static int	budgetlevel;		// steps below the player's setting
+static int	budgettime;		// average render time, ms << 4
+static int	budgethold;		// frames before the next step
+static int	budgetuphold;		// frames before the next step up
+static int	budgetbackoff = 1;
+static int	budgetsinceup = BUDGETHOLD*2;
+static int	budgetblocks = -1;
+static int	budgetdetail = -1;
+
+static void R_CheckFrameBudget (int ms)
+{
+    int		maxlevel;
+    int		level;
+    int		blocks;
+    int		detail;
+    int		budget;
+
+    // the player picked another size or detail
+    if (screenblocks != budgetblocks || detailLevel != budgetdetail)
+    {
+	budgetblocks = screenblocks;
+	budgetdetail = detailLevel;
+	budgetlevel = 0;
+	budgethold = BUDGETHOLD;
+	budgetuphold = 0;
+	budgetbackoff = 1;
+    }
+
+    budgettime += ((ms << 4) - budgettime) >> 3;
+
+    if (budgetsinceup < BUDGETHOLD*2)
+	budgetsinceup++;
+
+    if (budgetuphold > 0)
+	budgetuphold--;
+
+    if (budgethold > 0)
+    {
+	budgethold--;
+	return;
+    }
+
+    budget = frame_budget << 4;
+    maxlevel = (detailLevel ? 0 : 1) + screenblocks - BUDGETMINBLOCKS;
+
+    if (budgettime > budget && budgetlevel < maxlevel)
+    {
+	if (budgetsinceup < BUDGETHOLD*2)
+	{
+	    if (budgetbackoff < BUDGETMAXBACKOFF)
+		budgetbackoff <<= 1;
+	}
+	else
+	    budgetbackoff = 1;
+
+	budgetlevel++;
+	budgetuphold = BUDGETHOLD * budgetbackoff;
+    }
+    else if (budgettime < budget * (100 - frame_budget_hysteresis) / 100
+	     && budgetlevel > 0
+	     && !budgetuphold)
+    {
+	budgetlevel--;
+	budgetsinceup = 0;
+    }
+    else
+	return;
+
+    budgethold = BUDGETHOLD;
+
+    level = budgetlevel;
+    blocks = screenblocks;
+    detail = detailLevel;
+
+    if (level > 0 && !detail)
+    {
+	detail = 1;
+	level--;
+    }
+
+    blocks -= level;
+
+    R_SetViewSize (blocks, detail);
+
+    printf ("R_CheckFrameBudget: %d.%d ms average, %d ms budget: "
+	    "view size %d, %s detail, step %d of %d\n",
+	    budgettime >> 4, ((budgettime & 15) * 10) >> 4, frame_budget,
+	    blocks, detail ? "low" : "high", budgetlevel, maxlevel);
+}
+
+
+
 //
 // R_RenderView
 //
 void R_RenderPlayerView (player_t* player)
 {	
+    int		start;
+
+    start = I_GetTimeMS ();
+
     R_SetupFrame (player);
 
     // Clear buffers.
+    R_ClearArena ();
     R_ClearClipSegs ();
     R_ClearDrawSegs ();
     R_ClearPlanes ();
@@ -875,6 +998,7 @@ void R_RenderPlayerView (player_t* player)
 
     // The head node is the last node output.
     R_RenderBSPNode (numnodes-1);
+    R_BuildDrawSegIndex ();
     
     // Check for new console commands.
     NetUpdate ();
@@ -886,6 +1010,12 @@ void R_RenderPlayerView (player_t* player)
     
     R_DrawMasked ();
 
+    // The view window has changed completely.
+    V_MarkRect (viewwindowx, viewwindowy, scaledviewwidth, viewheight);
+
     // Check for new console commands.
     NetUpdate ();				
+
+    if (frame_budget)
+	R_CheckFrameBudget (I_GetTimeMS () - start);
 }
@@ -157,4 +157,11 @@ void R_Init (void);
 // Called by M_Responder.
 void R_SetViewSize (int blocks, int detail);
 
+// Render time per frame in ms the view size and detail are
+//  lowered to stay under, 0 to leave them as set.
+extern int		frame_budget;
+
+// Percent under frame_budget before they are raised again.
+extern int		frame_budget_hysteresis;
+
 #endif
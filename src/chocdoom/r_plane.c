@@ -42,17 +42,47 @@ planefunction_t		ceilingfunc;
 //
 
 // Here comes the obnoxious "visplane".
+// The vanilla limit, the pool grows past it.
 #define MAXVISPLANES	128
-visplane_t		visplanes[MAXVISPLANES];
+visplane_t*		visplanes;
 visplane_t*		lastvisplane;
 visplane_t*		floorplane;
 visplane_t*		ceilingplane;
 
+static renderpool_t	visplanepool = { "visplanes", sizeof(visplane_t), MAXVISPLANES };
+
+// Hash chains of the visplanes by height, picnum and lightlevel,
+//  as indices so they survive the pool growing.
+// Only planes made by R_FindPlane are linked, so a chain yields the
+//  first plane with its key, like the linear search did.
+#define VISPLANEHASHSIZE	128
+#define VISPLANEHASH(height, picnum, lightlevel) \
+    (((unsigned) ((height) >> FRACBITS) * 7 + (picnum) * 3 + (lightlevel)) \
+     & (VISPLANEHASHSIZE - 1))
+
+static int		visplanehash[VISPLANEHASHSIZE];
+
+// Statistics: lookups and chain entries passed over in R_FindPlane,
+//  and the number of visplanes summed over all frames and the most
+//  in one frame.
+unsigned int		visplane_lookups;
+unsigned int		visplane_collisions;
+unsigned int		visplane_frames;
+unsigned int		visplane_total;
+unsigned int		visplane_peak;
+
 // ?
+// The openings are taken in chunks of the vanilla size or more, as
+//  the drawsegs keep pointers into them.
 #define MAXOPENINGS	SCREENWIDTH*64
-short			openings[MAXOPENINGS];
+short*			openings;
 short*			lastopening;
 
+static renderpool_t	openingpool = { "openings", sizeof(short), MAXOPENINGS };
+
+// openings taken this frame, over all chunks
+static int		numopenings;
+
 
 //
 // Clip values are the solid pixel bounding the range.
@@ -187,8 +217,16 @@ void R_ClearPlanes (void)
 	ceilingclip[i] = -1;
     }
 
+    R_ResetPool (&visplanepool);
+    visplanes = visplanepool.base;
     lastvisplane = visplanes;
+
+    R_ResetPool (&openingpool);
+    openings = openingpool.base;
     lastopening = openings;
+    numopenings = 0;
+
+    memset (visplanehash, 0xff, sizeof(visplanehash));
     
     // texture calculation
     memset (cachedheight, 0, sizeof(cachedheight));
@@ -204,8 +242,64 @@ void R_ClearPlanes (void)
 
 
 
+//
+// R_AllocOpenings
+// Returns room for count openings. A full chunk is left in place
+//  for the drawsegs pointing into it and a new one is started.
+//
+short* R_AllocOpenings (int count)
+{
+    short*	p;
+
+    if (lastopening + count > openings + openingpool.size)
+    {
+	if (!R_NextPoolChunk (&openingpool))
+	    I_Error ("R_AllocOpenings: no more openings");
+
+	openings = openingpool.base;
+	lastopening = openings;
+    }
+
+    p = lastopening;
+    lastopening += count;
+    numopenings += count;
+
+    R_PoolUsed (&openingpool, numopenings);
+
+    return p;
+}
+
+
+//
+// R_GrowVisplanes
+// Moves floorplane and ceilingplane along with the pool.
+//
+static boolean R_GrowVisplanes (void)
+{
+    visplane_t*	old;
+
+    old = visplanes;
+
+    if (!R_GrowPool (&visplanepool))
+	return false;
+
+    visplanes = visplanepool.base;
+    lastvisplane = visplanes + (lastvisplane - old);
+
+    if (floorplane)
+	floorplane = visplanes + (floorplane - old);
+
+    if (ceilingplane)
+	ceilingplane = visplanes + (ceilingplane - old);
+
+    return true;
+}
+
+
 //
 // R_FindPlane
+// The columns of top[] are only marked empty when R_CheckPlane
+//  adds them to the plane's range, see R_ClearPlaneColumns.
 //
 visplane_t*
 R_FindPlane
@@ -214,44 +308,68 @@ R_FindPlane
   int		lightlevel )
 {
     visplane_t*	check;
+    unsigned	hash;
+    int		i;
 	
     if (picnum == skyflatnum)
     {
 	height = 0;			// all skys map together
 	lightlevel = 0;
     }
-	
-    for (check=visplanes; check<lastvisplane; check++)
+
+    visplane_lookups++;
+
+    hash = VISPLANEHASH(height, picnum, lightlevel);
+
+    for (i = visplanehash[hash]; i != -1; i = check->next)
     {
+	check = &visplanes[i];
+
 	if (height == check->height
 	    && picnum == check->picnum
 	    && lightlevel == check->lightlevel)
 	{
-	    break;
+	    return check;
 	}
+
+	visplane_collisions++;
     }
-    
-			
-    if (check < lastvisplane)
-	return check;
 		
-    if (lastvisplane - visplanes == MAXVISPLANES)
+    if (lastvisplane - visplanes == visplanepool.size && !R_GrowVisplanes ())
 	I_Error ("R_FindPlane: no more visplanes");
 		
-    lastvisplane++;
+    check = lastvisplane++;
+
+    R_PoolUsed (&visplanepool, lastvisplane - visplanes);
 
     check->height = height;
     check->picnum = picnum;
     check->lightlevel = lightlevel;
     check->minx = SCREENWIDTH;
     check->maxx = -1;
-    
-    memset (check->top,0xff,sizeof(check->top));
+
+    check->next = visplanehash[hash];
+    visplanehash[hash] = check - visplanes;
 		
     return check;
 }
 
 
+//
+// R_ClearPlaneColumns
+// Marks the columns start..stop of a plane as empty.
+//
+static void
+R_ClearPlaneColumns
+( visplane_t*	pl,
+  int		start,
+  int		stop )
+{
+    if (start <= stop)
+	memset (pl->top + start, 0xff, stop - start + 1);
+}
+
+
 //
 // R_CheckPlane
 //
@@ -266,6 +384,7 @@ R_CheckPlane
     int		unionl;
     int		unionh;
     int		x;
+    int		index;
 	
     if (start < pl->minx)
     {
@@ -295,6 +414,17 @@ R_CheckPlane
 
     if (x > intrh)
     {
+	// only the columns new to the range need clearing
+	if (pl->minx > pl->maxx)
+	{
+	    R_ClearPlaneColumns (pl, start, stop);
+	}
+	else
+	{
+	    R_ClearPlaneColumns (pl, unionl, pl->minx - 1);
+	    R_ClearPlaneColumns (pl, pl->maxx + 1, unionh);
+	}
+
 	pl->minx = unionl;
 	pl->maxx = unionh;
 
@@ -302,6 +432,16 @@ R_CheckPlane
 	return pl;		
     }
 	
+    if (lastvisplane - visplanes == visplanepool.size)
+    {
+	index = pl - visplanes;
+
+	if (!R_GrowVisplanes ())
+	    I_Error ("R_CheckPlane: no more visplanes");
+
+	pl = visplanes + index;
+    }
+
     // make a new visplane
     lastvisplane->height = pl->height;
     lastvisplane->picnum = pl->picnum;
@@ -311,7 +451,9 @@ R_CheckPlane
     pl->minx = start;
     pl->maxx = stop;
 
-    memset (pl->top,0xff,sizeof(pl->top));
+    R_ClearPlaneColumns (pl, start, stop);
+
+    R_PoolUsed (&visplanepool, lastvisplane - visplanes);
 		
     return pl;
 }
@@ -367,19 +509,25 @@ void R_DrawPlanes (void)
     int                 lumpnum;
 				
 #ifdef RANGECHECK
-    if (ds_p - drawsegs > MAXDRAWSEGS)
+    if (ds_p - drawsegs > drawsegpool.size)
 	I_Error ("R_DrawPlanes: drawsegs overflow (%i)",
 		 ds_p - drawsegs);
     
-    if (lastvisplane - visplanes > MAXVISPLANES)
+    if (lastvisplane - visplanes > visplanepool.size)
 	I_Error ("R_DrawPlanes: visplane overflow (%i)",
 		 lastvisplane - visplanes);
     
-    if (lastopening - openings > MAXOPENINGS)
+    if (lastopening - openings > openingpool.size)
 	I_Error ("R_DrawPlanes: opening overflow (%i)",
 		 lastopening - openings);
 #endif
 
+    visplane_frames++;
+    visplane_total += lastvisplane - visplanes;
+
+    if (lastvisplane - visplanes > visplane_peak)
+	visplane_peak = lastvisplane - visplanes;
+
     for (pl = visplanes ; pl < lastvisplane ; pl++)
     {
 	if (pl->minx > pl->maxx)
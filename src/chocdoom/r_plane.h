@@ -40,6 +40,12 @@ extern short		ceilingclip[SCREENWIDTH];
 extern fixed_t		yslope[SCREENHEIGHT];
 extern fixed_t		distscale[SCREENWIDTH];
 
+extern unsigned int	visplane_lookups;
+extern unsigned int	visplane_collisions;
+extern unsigned int	visplane_frames;
+extern unsigned int	visplane_total;
+extern unsigned int	visplane_peak;
+
 void R_InitPlanes (void);
 void R_ClearPlanes (void);
 
@@ -59,6 +65,8 @@ R_MakeSpans
 
 void R_DrawPlanes (void);
 
+short* R_AllocOpenings (int count);
+
 visplane_t*
 R_FindPlane
 ( fixed_t	height,
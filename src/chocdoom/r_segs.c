@@ -30,6 +30,7 @@
 #include "doomstat.h"
 
 #include "r_local.h"
+#include "r_colcache.h"
 #include "r_sky.h"
 
 
@@ -196,10 +197,39 @@ R_RenderMaskedSegRange
 #define HEIGHTBITS		12
 #define HEIGHTUNIT		(1<<HEIGHTBITS)
 
+//
+// R_SetWallColumn
+// Points dc_source at a wall column, taking it with the light
+//  applied from the column cache when it can and the run from
+//  dc_yl to dc_yh is long enough.
+//
+static void
+R_SetWallColumn
+( int		texnum,
+  int		texturecolumn,
+  lighttable_t*	colormap )
+{
+    if (dc_yh - dc_yl >= LITCOLUMNMINRUN)
+	dc_source = R_GetLitColumn(texnum, texturecolumn, colormap);
+    else
+	dc_source = NULL;
+
+    if (dc_source)
+    {
+	dc_colormap = identitymap;
+    }
+    else
+    {
+	dc_colormap = colormap;
+	dc_source = R_GetColumn(texnum, texturecolumn);
+    }
+}
+
 void R_RenderSegLoop (void)
 {
     angle_t		angle;
     unsigned		index;
+    lighttable_t*	walllight;
     int			yl;
     int			yh;
     int			mid;
@@ -262,7 +292,7 @@ void R_RenderSegLoop (void)
 	    if (index >=  MAXLIGHTSCALE )
 		index = MAXLIGHTSCALE-1;
 
-	    dc_colormap = walllights[index];
+	    walllight = walllights[index];
 	    dc_x = rw_x;
 	    dc_iscale = 0xffffffffu / (unsigned)rw_scale;
 	}
@@ -271,6 +301,7 @@ void R_RenderSegLoop (void)
             // purely to shut up the compiler
 
             texturecolumn = 0;
+            walllight = NULL;
         }
 	
 	// draw the wall tiers
@@ -280,7 +311,7 @@ void R_RenderSegLoop (void)
 	    dc_yl = yl;
 	    dc_yh = yh;
 	    dc_texturemid = rw_midtexturemid;
-	    dc_source = R_GetColumn(midtexture,texturecolumn);
+	    R_SetWallColumn(midtexture, texturecolumn, walllight);
 	    colfunc ();
 	    ceilingclip[rw_x] = viewheight;
 	    floorclip[rw_x] = -1;
@@ -302,7 +333,7 @@ void R_RenderSegLoop (void)
 		    dc_yl = yl;
 		    dc_yh = mid;
 		    dc_texturemid = rw_toptexturemid;
-		    dc_source = R_GetColumn(toptexture,texturecolumn);
+		    R_SetWallColumn(toptexture, texturecolumn, walllight);
 		    colfunc ();
 		    ceilingclip[rw_x] = mid;
 		}
@@ -331,8 +362,7 @@ void R_RenderSegLoop (void)
 		    dc_yl = mid;
 		    dc_yh = yh;
 		    dc_texturemid = rw_bottomtexturemid;
-		    dc_source = R_GetColumn(bottomtexture,
-					    texturecolumn);
+		    R_SetWallColumn(bottomtexture, texturecolumn, walllight);
 		    colfunc ();
 		    floorclip[rw_x] = mid;
 		}
@@ -380,7 +410,7 @@ R_StoreWallRange
     int			lightnum;
 
     // don't overflow and crash
-    if (ds_p == &drawsegs[MAXDRAWSEGS])
+    if (ds_p == drawsegs + drawsegpool.size && !R_GrowDrawSegs ())
 	return;		
 		
 #ifdef RANGECHECK
@@ -605,8 +635,8 @@ R_StoreWallRange
 	{
 	    // masked midtexture
 	    maskedtexture = true;
-	    ds_p->maskedtexturecol = maskedtexturecol = lastopening - rw_x;
-	    lastopening += rw_stopx - rw_x;
+	    ds_p->maskedtexturecol = maskedtexturecol
+		= R_AllocOpenings (rw_stopx - rw_x) - rw_x;
 	}
     }
     
@@ -715,17 +745,15 @@ R_StoreWallRange
     if ( ((ds_p->silhouette & SIL_TOP) || maskedtexture)
 	 && !ds_p->sprtopclip)
     {
-	memcpy (lastopening, ceilingclip+start, 2*(rw_stopx-start));
-	ds_p->sprtopclip = lastopening - start;
-	lastopening += rw_stopx - start;
+	ds_p->sprtopclip = R_AllocOpenings (rw_stopx - start) - start;
+	memcpy (ds_p->sprtopclip+start, ceilingclip+start, 2*(rw_stopx-start));
     }
     
     if ( ((ds_p->silhouette & SIL_BOTTOM) || maskedtexture)
 	 && !ds_p->sprbottomclip)
     {
-	memcpy (lastopening, floorclip+start, 2*(rw_stopx-start));
-	ds_p->sprbottomclip = lastopening - start;
-	lastopening += rw_stopx - start;	
+	ds_p->sprbottomclip = R_AllocOpenings (rw_stopx - start) - start;
+	memcpy (ds_p->sprbottomclip+start, floorclip+start, 2*(rw_stopx-start));
     }
 
     if (maskedtexture && !(ds_p->silhouette&SIL_TOP))
@@ -739,5 +767,7 @@ R_StoreWallRange
 	ds_p->bsilheight = INT_MAX;
     }
     ds_p++;
+
+    R_PoolUsed (&drawsegpool, ds_p - drawsegs);
 }
 
@@ -37,6 +37,10 @@
 // needed for texture pegging
 extern fixed_t*		textureheight;
 
+// needed for checking the column drawers
+extern int		numtextures;
+extern int*		texturewidthmask;
+
 // needed for pre rendering (fracs)
 extern fixed_t*		spritewidth;
 
@@ -50,6 +54,7 @@ extern int		scaledviewwidth;
 extern int		viewheight;
 
 extern int		firstflat;
+extern int		numflats;
 
 // for global animation
 extern int*		flattranslation;	
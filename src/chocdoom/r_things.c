@@ -278,12 +278,16 @@ void R_InitSpriteDefs (char** namelist)
 //
 // GAME FUNCTIONS
 //
-vissprite_t	vissprites[MAXVISSPRITES];
+vissprite_t*	vissprites;
 vissprite_t*	vissprite_p;
+
+static renderpool_t	visspritepool = { "vissprites", sizeof(vissprite_t), MAXVISSPRITES };
 int		newvissprite;
 
 
 
+static void R_CheckSpriteSort (void);
+
 //
 // R_InitSprites
 // Called at program start.
@@ -298,6 +302,9 @@ void R_InitSprites (char** namelist)
     }
 	
     R_InitSpriteDefs (namelist);
+
+    if (sprite_sort_check)
+	R_CheckSpriteSort ();
 }
 
 
@@ -308,6 +315,8 @@ void R_InitSprites (char** namelist)
 //
 void R_ClearSprites (void)
 {
+    R_ResetPool (&visspritepool);
+    vissprites = visspritepool.base;
     vissprite_p = vissprites;
 }
 
@@ -319,10 +328,23 @@ vissprite_t	overflowsprite;
 
 vissprite_t* R_NewVisSprite (void)
 {
-    if (vissprite_p == &vissprites[MAXVISSPRITES])
-	return &overflowsprite;
+    vissprite_t*	old;
+
+    if (vissprite_p == vissprites + visspritepool.size)
+    {
+	old = vissprites;
+
+	if (!R_GrowPool (&visspritepool))
+	    return &overflowsprite;
+
+	vissprites = visspritepool.base;
+	vissprite_p = vissprites + (vissprite_p - old);
+    }
     
     vissprite_p++;
+
+    R_PoolUsed (&visspritepool, vissprite_p - vissprites);
+
     return vissprite_p-1;
 }
 
@@ -775,8 +797,17 @@ void R_DrawPlayerSprites (void)
 //
 vissprite_t	vsprsortedhead;
 
+// If non-zero, R_InitSprites compares R_SortVisSprites with the
+// original selection sort on random sprite sets.
 
-void R_SortVisSprites (void)
+int		sprite_sort_check = 0;
+
+
+//
+// R_SortVisSpritesReference
+// The original selection sort, kept as the reference for the check.
+//
+static void R_SortVisSpritesReference (void)
 {
     int			i;
     int			count;
@@ -828,101 +859,382 @@ void R_SortVisSprites (void)
 }
 
 
+//
+// R_MergeVisSprites
+// Merges two NULL terminated lists sorted by scale. On equal scales
+//  the sprites of a, which came first, stay first.
+//
+static vissprite_t*
+R_MergeVisSprites
+( vissprite_t*	a,
+  vissprite_t*	b )
+{
+    vissprite_t*	list;
+    vissprite_t**	tail;
+
+    tail = &list;
+
+    while (a && b)
+    {
+	if (b->scale < a->scale)
+	{
+	    *tail = b;
+	    b = b->next;
+	}
+	else
+	{
+	    *tail = a;
+	    a = a->next;
+	}
+
+	tail = &(*tail)->next;
+    }
+
+    *tail = a ? a : b;
+
+    return list;
+}
+
 
 //
-// R_DrawSprite
+// R_SortVisSprites
+// Bottom-up merge sort by scale, smallest first. The selection sort
+//  it replaces picked the first of equal scales, so the merge sort
+//  is stable to draw in the same order.
+// runs[i] holds a sorted run of 2^i sprites, earlier sprites in
+//  higher runs, like the digits of a binary counter.
 //
-void R_DrawSprite (vissprite_t* spr)
+void R_SortVisSprites (void)
+{
+    vissprite_t*	runs[32];
+    vissprite_t*	carry;
+    vissprite_t*	ds;
+    vissprite_t*	prev;
+    int			i;
+
+    if (vissprite_p == vissprites)
+	return;
+
+    memset (runs, 0, sizeof(runs));
+
+    for (ds=vissprites ; ds<vissprite_p ; ds++)
+    {
+	carry = ds;
+	carry->next = NULL;
+
+	for (i=0 ; runs[i] ; i++)
+	{
+	    carry = R_MergeVisSprites (runs[i], carry);
+	    runs[i] = NULL;
+	}
+
+	runs[i] = carry;
+    }
+
+    carry = NULL;
+
+    for (i=0 ; i<arrlen(runs) ; i++)
+    {
+	if (runs[i])
+	    carry = R_MergeVisSprites (runs[i], carry);
+    }
+
+    // link it into the sorted ring
+    prev = &vsprsortedhead;
+
+    for (ds=carry ; ds ; ds=ds->next)
+    {
+	ds->prev = prev;
+	prev->next = ds;
+	prev = ds;
+    }
+
+    prev->next = &vsprsortedhead;
+    vsprsortedhead.prev = prev;
+}
+
+
+//
+// R_CheckSpriteSort
+// Sorts random sprite sets, with many equal scales, with both
+//  R_SortVisSprites and the reference and reports differing orders.
+//
+static void R_CheckSpriteSort (void)
+{
+    vissprite_t*	saved_vissprites;
+    vissprite_t*	saved_vissprite_p;
+    vissprite_t*	sprites;
+    vissprite_t*	order[MAXVISSPRITES*2];
+    vissprite_t*	ds;
+    int			count;
+    int			test;
+    int			mismatches;
+    int			i;
+
+    saved_vissprites = vissprites;
+    saved_vissprite_p = vissprite_p;
+
+    sprites = Z_Malloc (arrlen(order) * sizeof(vissprite_t), PU_STATIC, NULL);
+    mismatches = 0;
+
+    for (test = 0; test < 1000; test++)
+    {
+	count = rand() % (arrlen(order) + 1);
+
+	for (i = 0; i < count; i++)
+	{
+	    switch (test % 4)
+	    {
+	      case 0:
+		sprites[i].scale = rand();
+		break;
+	      case 1:
+		sprites[i].scale = (rand() % 8) << FRACBITS;
+		break;
+	      case 2:
+		sprites[i].scale = rand() % 2 ? INT_MAX : rand() % 3;
+		break;
+	      default:
+		sprites[i].scale = FRACUNIT;
+		break;
+	    }
+	}
+
+	vissprites = sprites;
+	vissprite_p = sprites + count;
+
+	R_SortVisSpritesReference ();
+
+	i = 0;
+	if (count)
+	{
+	    for (ds = vsprsortedhead.next; ds != &vsprsortedhead; ds = ds->next)
+		order[i++] = ds;
+	}
+
+	R_SortVisSprites ();
+
+	if (!count)
+	    continue;
+
+	for (i = 0, ds = vsprsortedhead.next; ds != &vsprsortedhead; ds = ds->next, i++)
+	{
+	    if (i == count || ds != order[i] || ds->next->prev != ds)
+		break;
+	}
+
+	if (i != count || ds != &vsprsortedhead)
+	    mismatches++;
+    }
+
+    printf ("R_CheckSpriteSort: %d of %d orders differ\n", mismatches, test);
+
+    Z_Free (sprites);
+
+    vissprites = saved_vissprites;
+    vissprite_p = saved_vissprite_p;
+}
+
+
+
+//
+// Drawseg index for sprite clipping. For every group of
+//  1 << DSINDEXSHIFT columns it holds a bitmap of the drawsegs that
+//  can clip sprites there, those with a silhouette or a masked
+//  texture. A sprite only visits the drawsegs of its columns, still
+//  from the last to the first.
+//
+#define DSINDEXSHIFT	3
+#define DSINDEXBUCKETS	((SCREENWIDTH + (1 << DSINDEXSHIFT) - 1) >> DSINDEXSHIFT)
+
+static uint32_t*	dsindex;	// a row of dsindexwords per bucket
+static uint32_t*	dsmask;		// drawsegs of the current sprite
+static int		dsindexwords;
+
+
+//
+// R_BuildDrawSegIndex
+// Called after the BSP traversal, when all drawsegs are known.
+//
+void R_BuildDrawSegIndex (void)
 {
     drawseg_t*		ds;
-    short		clipbot[SCREENWIDTH];
-    short		cliptop[SCREENWIDTH];
+    uint32_t*		word;
+    uint32_t		bit;
+    int			b;
+    int			i;
+
+    dsindexwords = (ds_p - drawsegs + 31) >> 5;
+    dsindex = R_ArenaAlloc ((DSINDEXBUCKETS + 1) * dsindexwords * sizeof(*dsindex));
+
+    // without the index all drawsegs are scanned
+    if (dsindex == NULL)
+	return;
+
+    dsmask = dsindex + DSINDEXBUCKETS * dsindexwords;
+    memset (dsindex, 0, DSINDEXBUCKETS * dsindexwords * sizeof(*dsindex));
+
+    for (ds=drawsegs ; ds<ds_p ; ds++)
+    {
+	if (!ds->silhouette && !ds->maskedtexturecol)
+	    continue;
+
+	i = ds - drawsegs;
+	word = dsindex + (ds->x1 >> DSINDEXSHIFT) * dsindexwords + (i >> 5);
+	bit = 1u << (i & 31);
+
+	for (b = ds->x1 >> DSINDEXSHIFT ; b <= ds->x2 >> DSINDEXSHIFT ; b++)
+	{
+	    *word |= bit;
+	    word += dsindexwords;
+	}
+    }
+}
+
+
+//
+// R_ClipSpriteSeg
+// Clips the sprite to one drawseg, or draws the masked mid texture
+//  of the drawseg if it is behind the sprite.
+//
+static void
+R_ClipSpriteSeg
+( vissprite_t*	spr,
+  drawseg_t*	ds,
+  short*	clipbot,
+  short*	cliptop )
+{
     int			x;
     int			r1;
     int			r2;
     fixed_t		scale;
     fixed_t		lowscale;
     int			silhouette;
-		
-    for (x = spr->x1 ; x<=spr->x2 ; x++)
-	clipbot[x] = cliptop[x] = -2;
-    
-    // Scan drawsegs from end to start for obscuring segs.
-    // The first drawseg that has a greater scale
-    //  is the clip seg.
-    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+
+    // determine if the drawseg obscures the sprite
+    if (ds->x1 > spr->x2
+	|| ds->x2 < spr->x1
+	|| (!ds->silhouette
+	    && !ds->maskedtexturecol) )
     {
-	// determine if the drawseg obscures the sprite
-	if (ds->x1 > spr->x2
-	    || ds->x2 < spr->x1
-	    || (!ds->silhouette
-		&& !ds->maskedtexturecol) )
-	{
-	    // does not cover sprite
-	    continue;
-	}
+	// does not cover sprite
+	return;
+    }
 			
-	r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-	r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+    r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
+    r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
 
-	if (ds->scale1 > ds->scale2)
-	{
-	    lowscale = ds->scale2;
-	    scale = ds->scale1;
-	}
-	else
-	{
-	    lowscale = ds->scale1;
-	    scale = ds->scale2;
-	}
+    if (ds->scale1 > ds->scale2)
+    {
+	lowscale = ds->scale2;
+	scale = ds->scale1;
+    }
+    else
+    {
+	lowscale = ds->scale1;
+	scale = ds->scale2;
+    }
 		
-	if (scale < spr->scale
-	    || ( lowscale < spr->scale
-		 && !R_PointOnSegSide (spr->gx, spr->gy, ds->curline) ) )
-	{
-	    // masked mid texture?
-	    if (ds->maskedtexturecol)	
-		R_RenderMaskedSegRange (ds, r1, r2);
-	    // seg is behind sprite
-	    continue;			
-	}
+    if (scale < spr->scale
+	|| ( lowscale < spr->scale
+	     && !R_PointOnSegSide (spr->gx, spr->gy, ds->curline) ) )
+    {
+	// masked mid texture?
+	if (ds->maskedtexturecol)	
+	    R_RenderMaskedSegRange (ds, r1, r2);
+	// seg is behind sprite
+	return;			
+    }
 
 	
-	// clip this piece of the sprite
-	silhouette = ds->silhouette;
+    // clip this piece of the sprite
+    silhouette = ds->silhouette;
 	
-	if (spr->gz >= ds->bsilheight)
-	    silhouette &= ~SIL_BOTTOM;
+    if (spr->gz >= ds->bsilheight)
+	silhouette &= ~SIL_BOTTOM;
 
-	if (spr->gzt <= ds->tsilheight)
-	    silhouette &= ~SIL_TOP;
+    if (spr->gzt <= ds->tsilheight)
+	silhouette &= ~SIL_TOP;
 			
-	if (silhouette == 1)
+    if (silhouette == 1)
+    {
+	// bottom sil
+	for (x=r1 ; x<=r2 ; x++)
+	    if (clipbot[x] == -2)
+		clipbot[x] = ds->sprbottomclip[x];
+    }
+    else if (silhouette == 2)
+    {
+	// top sil
+	for (x=r1 ; x<=r2 ; x++)
+	    if (cliptop[x] == -2)
+		cliptop[x] = ds->sprtopclip[x];
+    }
+    else if (silhouette == 3)
+    {
+	// both
+	for (x=r1 ; x<=r2 ; x++)
 	{
-	    // bottom sil
-	    for (x=r1 ; x<=r2 ; x++)
-		if (clipbot[x] == -2)
-		    clipbot[x] = ds->sprbottomclip[x];
+	    if (clipbot[x] == -2)
+		clipbot[x] = ds->sprbottomclip[x];
+	    if (cliptop[x] == -2)
+		cliptop[x] = ds->sprtopclip[x];
 	}
-	else if (silhouette == 2)
+    }
+}
+
+
+//
+// R_DrawSprite
+//
+void R_DrawSprite (vissprite_t* spr)
+{
+    drawseg_t*		ds;
+    short		clipbot[SCREENWIDTH];
+    short		cliptop[SCREENWIDTH];
+    uint32_t*		row;
+    uint32_t		bits;
+    int			x;
+    int			b;
+    int			w;
+		
+    for (x = spr->x1 ; x<=spr->x2 ; x++)
+	clipbot[x] = cliptop[x] = -2;
+    
+    // Scan drawsegs from end to start for obscuring segs.
+    // The first drawseg that has a greater scale
+    //  is the clip seg.
+    if (dsindex == NULL)
+    {
+	for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+	    R_ClipSpriteSeg (spr, ds, clipbot, cliptop);
+    }
+    else
+    {
+	// collect the drawsegs of the sprite's columns
+	row = dsindex + (spr->x1 >> DSINDEXSHIFT) * dsindexwords;
+	memcpy (dsmask, row, dsindexwords * sizeof(*dsmask));
+
+	for (b = (spr->x1 >> DSINDEXSHIFT) + 1 ; b <= spr->x2 >> DSINDEXSHIFT ; b++)
 	{
-	    // top sil
-	    for (x=r1 ; x<=r2 ; x++)
-		if (cliptop[x] == -2)
-		    cliptop[x] = ds->sprtopclip[x];
+	    row += dsindexwords;
+
+	    for (w = 0 ; w < dsindexwords ; w++)
+		dsmask[w] |= row[w];
 	}
-	else if (silhouette == 3)
+
+	for (w = dsindexwords - 1 ; w >= 0 ; w--)
 	{
-	    // both
-	    for (x=r1 ; x<=r2 ; x++)
+	    bits = dsmask[w];
+
+	    while (bits)
 	    {
-		if (clipbot[x] == -2)
-		    clipbot[x] = ds->sprbottomclip[x];
-		if (cliptop[x] == -2)
-		    cliptop[x] = ds->sprtopclip[x];
+		b = 31 - __builtin_clz (bits);
+		bits &= ~(1u << b);
+
+		R_ClipSpriteSeg (spr, drawsegs + (w << 5) + b, clipbot, cliptop);
 	    }
 	}
-		
     }
     
     // all clipping has been performed, so draw the sprite
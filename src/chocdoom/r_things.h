@@ -22,12 +22,15 @@
 
 
 
+// The vanilla limit, the pool grows past it.
 #define MAXVISSPRITES  	128
 
-extern vissprite_t	vissprites[MAXVISSPRITES];
+extern vissprite_t*	vissprites;
 extern vissprite_t*	vissprite_p;
 extern vissprite_t	vsprsortedhead;
 
+extern int		sprite_sort_check;
+
 // Constant arrays used for psprite clipping
 //  and initializing clipping.
 extern short		negonearray[SCREENWIDTH];
@@ -48,6 +51,8 @@ void R_DrawMaskedColumn (column_t* column);
 
 void R_SortVisSprites (void);
 
+void R_BuildDrawSegIndex (void);
+
 void R_AddSprites (sector_t* sec);
 void R_AddPSprites (void);
 void R_DrawSprites (void);
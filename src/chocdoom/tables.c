@@ -30,6 +30,7 @@
 //	
 //    
 
+#include "placement.h"
 #include "tables.h"
 
 // to get a global angle from cartesian coordinates, the coordinates are
@@ -61,7 +62,7 @@ int SlopeDiv(unsigned int num, unsigned int den)
     }
 }
 
-const int finetangent[4096] =
+const int finetangent[4096] FINETANGENT_PLACEMENT =
 {
     -170910304,-56965752,-34178904,-24413316,-18988036,-15535599,-13145455,-11392683,
     -10052327,-8994149,-8137527,-7429880,-6835455,-6329090,-5892567,-5512368,
@@ -578,7 +579,7 @@ const int finetangent[4096] =
 };
 
 
-const int finesine[10240] =
+const int finesine[10240] FINESINE_PLACEMENT =
 {
     25,75,125,175,226,276,326,376,
     427,477,527,578,628,678,728,779,
@@ -1864,7 +1865,7 @@ const int finesine[10240] =
 
 const fixed_t *finecosine = &finesine[FINEANGLES/4];
 
-const angle_t tantoangle[2049] =
+const angle_t tantoangle[2049] TANTOANGLE_PLACEMENT =
 {
     0,333772,667544,1001315,1335086,1668857,2002626,2336395,
     2670163,3003929,3337694,3671457,4005219,4338979,4672736,5006492,
@@ -2126,7 +2127,7 @@ const angle_t tantoangle[2049] =
 };
 
 // Now where did these came from?
-const byte gammatable[5][256] =
+const byte gammatable[5][256] GAMMATABLE_PLACEMENT =
 {
     {
         1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,
@@ -105,15 +105,24 @@ void V_CopyRect(int srcx, int srcy, byte *source,
 
     V_MarkRect(destx, desty, width, height); 
  
-    src = source + SCREENWIDTH * srcy + srcx; 
-    dest = dest_screen + SCREENWIDTH * desty + destx; 
+    src = source + SCREENOFS(srcx, srcy); 
+    dest = dest_screen + SCREENOFS(destx, desty); 
 
+#ifdef FEATURE_COLUMN_MAJOR
+    for ( ; width>0 ; width--) 
+    { 
+        memcpy(dest, src, height); 
+        src += SCREENXSTEP; 
+        dest += SCREENXSTEP; 
+    } 
+#else
     for ( ; height>0 ; height--) 
     { 
         memcpy(dest, src, width); 
-        src += SCREENWIDTH; 
-        dest += SCREENWIDTH; 
+        src += SCREENYSTEP; 
+        dest += SCREENYSTEP; 
     } 
+#endif
 } 
  
 //
@@ -169,11 +178,11 @@ void V_DrawPatch(int x, int y, patch_t *patch)
     V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x, y);
 
     w = SHORT(patch->width);
 
-    for ( ; col<w ; x++, col++, desttop++)
+    for ( ; col<w ; x++, col++, desttop += SCREENXSTEP)
     {
         column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
 
@@ -181,13 +190,13 @@ void V_DrawPatch(int x, int y, patch_t *patch)
         while (column->topdelta != 0xff)
         {
             source = (byte *)column + 3;
-            dest = desttop + column->topdelta*SCREENWIDTH;
+            dest = desttop + column->topdelta*SCREENYSTEP;
             count = column->length;
 
             while (count--)
             {
                 *dest = *source++;
-                dest += SCREENWIDTH;
+                dest += SCREENYSTEP;
             }
             column = (column_t *)((byte *)column + column->length + 4);
         }
@@ -233,11 +242,11 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
     V_MarkRect (x, y, SHORT(patch->width), SHORT(patch->height));
 
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x, y);
 
     w = SHORT(patch->width);
 
-    for ( ; col<w ; x++, col++, desttop++)
+    for ( ; col<w ; x++, col++, desttop += SCREENXSTEP)
     {
         column = (column_t *)((byte *)patch + LONG(patch->columnofs[w-1-col]));
 
@@ -245,13 +254,13 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
         while (column->topdelta != 0xff )
         {
             source = (byte *)column + 3;
-            dest = desttop + column->topdelta*SCREENWIDTH;
+            dest = desttop + column->topdelta*SCREENYSTEP;
             count = column->length;
 
             while (count--)
             {
                 *dest = *source++;
-                dest += SCREENWIDTH;
+                dest += SCREENYSTEP;
             }
             column = (column_t *)((byte *)column + column->length + 4);
         }
@@ -294,11 +303,13 @@ void V_DrawTLPatch(int x, int y, patch_t * patch)
         I_Error("Bad V_DrawTLPatch");
     }
 
+    V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
+
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x, y);
 
     w = SHORT(patch->width);
-    for (; col < w; x++, col++, desttop++)
+    for (; col < w; x++, col++, desttop += SCREENXSTEP)
     {
         column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
 
@@ -307,13 +318,13 @@ void V_DrawTLPatch(int x, int y, patch_t * patch)
         while (column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
+            dest = desttop + column->topdelta * SCREENYSTEP;
             count = column->length;
 
             while (count--)
             {
                 *dest = tinttable[((*dest) << 8) + *source++];
-                dest += SCREENWIDTH;
+                dest += SCREENYSTEP;
             }
             column = (column_t *) ((byte *) column + column->length + 4);
         }
@@ -342,11 +353,13 @@ void V_DrawXlaPatch(int x, int y, patch_t * patch)
             return;
     }
 
+    V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
+
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x, y);
 
     w = SHORT(patch->width);
-    for(; col < w; x++, col++, desttop++)
+    for(; col < w; x++, col++, desttop += SCREENXSTEP)
     {
         column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
 
@@ -355,14 +368,14 @@ void V_DrawXlaPatch(int x, int y, patch_t * patch)
         while(column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
+            dest = desttop + column->topdelta * SCREENYSTEP;
             count = column->length;
 
             while(count--)
             {
                 *dest = xlatab[*dest + ((*source) << 8)];
                 source++;
-                dest += SCREENWIDTH;
+                dest += SCREENYSTEP;
             }
             column = (column_t *) ((byte *) column + column->length + 4);
         }
@@ -393,11 +406,13 @@ void V_DrawAltTLPatch(int x, int y, patch_t * patch)
         I_Error("Bad V_DrawAltTLPatch");
     }
 
+    V_MarkRect(x, y, SHORT(patch->width), SHORT(patch->height));
+
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
+    desttop = dest_screen + SCREENOFS(x, y);
 
     w = SHORT(patch->width);
-    for (; col < w; x++, col++, desttop++)
+    for (; col < w; x++, col++, desttop += SCREENXSTEP)
     {
         column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
 
@@ -406,13 +421,13 @@ void V_DrawAltTLPatch(int x, int y, patch_t * patch)
         while (column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
+            dest = desttop + column->topdelta * SCREENYSTEP;
             count = column->length;
 
             while (count--)
             {
                 *dest = tinttable[((*dest) << 8) + *source++];
-                dest += SCREENWIDTH;
+                dest += SCREENYSTEP;
             }
             column = (column_t *) ((byte *) column + column->length + 4);
         }
@@ -444,12 +459,14 @@ void V_DrawShadowedPatch(int x, int y, patch_t *patch)
         I_Error("Bad V_DrawShadowedPatch");
     }
 
+    V_MarkRect(x, y, SHORT(patch->width) + 2, SHORT(patch->height) + 2);
+
     col = 0;
-    desttop = dest_screen + y * SCREENWIDTH + x;
-    desttop2 = dest_screen + (y + 2) * SCREENWIDTH + x + 2;
+    desttop = dest_screen + SCREENOFS(x, y);
+    desttop2 = dest_screen + SCREENOFS(x + 2, y + 2);
 
     w = SHORT(patch->width);
-    for (; col < w; x++, col++, desttop++, desttop2++)
+    for (; col < w; x++, col++, desttop += SCREENXSTEP, desttop2 += SCREENXSTEP)
     {
         column = (column_t *) ((byte *) patch + LONG(patch->columnofs[col]));
 
@@ -458,16 +475,16 @@ void V_DrawShadowedPatch(int x, int y, patch_t *patch)
         while (column->topdelta != 0xff)
         {
             source = (byte *) column + 3;
-            dest = desttop + column->topdelta * SCREENWIDTH;
-            dest2 = desttop2 + column->topdelta * SCREENWIDTH;
+            dest = desttop + column->topdelta * SCREENYSTEP;
+            dest2 = desttop2 + column->topdelta * SCREENYSTEP;
             count = column->length;
 
             while (count--)
             {
                 *dest2 = tinttable[((*dest2) << 8)];
-                dest2 += SCREENWIDTH;
+                dest2 += SCREENYSTEP;
                 *dest = *source++;
-                dest += SCREENWIDTH;
+                dest += SCREENYSTEP;
 
             }
             column = (column_t *) ((byte *) column + column->length + 4);
@@ -516,14 +533,25 @@ void V_DrawBlock(int x, int y, int width, int height, byte *src)
  
     V_MarkRect (x, y, width, height); 
  
-    dest = dest_screen + y * SCREENWIDTH + x; 
+    dest = dest_screen + SCREENOFS(x, y); 
+
+#ifdef FEATURE_COLUMN_MAJOR
+    // src is a column-major block, like the screen
 
+    while (width--) 
+    { 
+	memcpy (dest, src, height); 
+	src += height; 
+	dest += SCREENXSTEP; 
+    } 
+#else
     while (height--) 
     { 
 	memcpy (dest, src, width); 
 	src += width; 
 	dest += SCREENWIDTH; 
     } 
+#endif
 } 
 
 void V_DrawFilledBox(int x, int y, int w, int h, int c)
@@ -531,7 +559,9 @@ void V_DrawFilledBox(int x, int y, int w, int h, int c)
     uint8_t *buf, *buf1;
     int x1, y1;
 
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
+    V_MarkRect(x, y, w, h);
+
+    buf = I_VideoBuffer + SCREENOFS(x, y);
 
     for (y1 = 0; y1 < h; ++y1)
     {
@@ -539,10 +569,11 @@ void V_DrawFilledBox(int x, int y, int w, int h, int c)
 
         for (x1 = 0; x1 < w; ++x1)
         {
-            *buf1++ = c;
+            *buf1 = c;
+            buf1 += SCREENXSTEP;
         }
 
-        buf += SCREENWIDTH;
+        buf += SCREENYSTEP;
     }
 }
 
@@ -551,11 +582,14 @@ void V_DrawHorizLine(int x, int y, int w, int c)
     uint8_t *buf;
     int x1;
 
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
+    V_MarkRect(x, y, w, 1);
+
+    buf = I_VideoBuffer + SCREENOFS(x, y);
 
     for (x1 = 0; x1 < w; ++x1)
     {
-        *buf++ = c;
+        *buf = c;
+        buf += SCREENXSTEP;
     }
 }
 
@@ -564,12 +598,14 @@ void V_DrawVertLine(int x, int y, int h, int c)
     uint8_t *buf;
     int y1;
 
-    buf = I_VideoBuffer + SCREENWIDTH * y + x;
+    V_MarkRect(x, y, 1, h);
+
+    buf = I_VideoBuffer + SCREENOFS(x, y);
 
     for (y1 = 0; y1 < h; ++y1)
     {
         *buf = c;
-        buf += SCREENWIDTH;
+        buf += SCREENYSTEP;
     }
 }
 
@@ -588,7 +624,19 @@ void V_DrawBox(int x, int y, int w, int h, int c)
  
 void V_DrawRawScreen(byte *raw)
 {
+    V_MarkRect(0, 0, SCREENWIDTH, SCREENHEIGHT);
+
+#ifdef FEATURE_COLUMN_MAJOR
+    int x, y;
+
+    // raw screens are stored row-major
+
+    for (y = 0; y < SCREENHEIGHT; y++)
+        for (x = 0; x < SCREENWIDTH; x++)
+            dest_screen[SCREENOFS(x, y)] = *raw++;
+#else
     memcpy(dest_screen, raw, SCREENWIDTH * SCREENHEIGHT);
+#endif
 }
 
 //
@@ -682,6 +730,18 @@ void WritePCXfile(char *filename, byte *data,
 	
     for (i=0 ; i<width*height ; i++)
     {
+#ifdef FEATURE_COLUMN_MAJOR
+	// PCX lines are rows; pick the pixels from the columns
+	byte pixel = data[SCREENOFS(i % width, i / width)];
+
+	if ( (pixel & 0xc0) != 0xc0)
+	    *pack++ = pixel;
+	else
+	{
+	    *pack++ = 0xc1;
+	    *pack++ = pixel;
+	}
+#else
 	if ( (*data & 0xc0) != 0xc0)
 	    *pack++ = *data++;
 	else
@@ -689,6 +749,7 @@ void WritePCXfile(char *filename, byte *data,
 	    *pack++ = 0xc1;
 	    *pack++ = *data++;
 	}
+#endif
     }
     
     // write the palette
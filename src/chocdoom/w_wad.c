@@ -65,6 +65,11 @@ unsigned int numlumps = 0;
 
 static lumpinfo_t **lumphash;
 
+// One bit per lump that the zone purged from the cache, so that
+// reading it again shows up in the zone stats.
+
+static byte *lumppurged;
+
 // Hash function used for lump names.
 
 unsigned int W_LumpNameHash(const char *s)
@@ -83,10 +88,31 @@ unsigned int W_LumpNameHash(const char *s)
     return result;
 }
 
+// Called by the zone for every purgable block it throws out.
+// Only the lump cache has users in lumpinfo[].
+
+static void W_LumpPurged(void **user)
+{
+    unsigned int lumpnum;
+
+    if ((byte *) user < (byte *) lumpinfo)
+    {
+        return;
+    }
+
+    lumpnum = ((byte *) user - (byte *) lumpinfo) / sizeof(lumpinfo_t);
+
+    if (lumpnum < numlumps && user == &lumpinfo[lumpnum].cache)
+    {
+        lumppurged[lumpnum >> 3] |= 1 << (lumpnum & 7);
+    }
+}
+
 // Increase the size of the lumpinfo[] array to the specified size.
 static void ExtendLumpInfo(int newnumlumps)
 {
     lumpinfo_t *newlumpinfo;
+    byte *newlumppurged;
     unsigned int i;
 
     newlumpinfo = calloc(newnumlumps, sizeof(lumpinfo_t));
@@ -117,9 +143,27 @@ static void ExtendLumpInfo(int newnumlumps)
         }
     }
 
+    newlumppurged = calloc((newnumlumps + 7) / 8, 1);
+
+    if (newlumppurged == NULL)
+    {
+        I_Error ("Couldn't realloc lumppurged");
+    }
+
+    if (lumppurged != NULL)
+    {
+        memcpy(newlumppurged, lumppurged, (numlumps + 7) / 8);
+        free(lumppurged);
+    }
+    else
+    {
+        Z_SetPurgeHook(W_LumpPurged);
+    }
+
     // All done.
     free(lumpinfo);
     lumpinfo = newlumpinfo;
+    lumppurged = newlumppurged;
     numlumps = newnumlumps;
 }
 
@@ -413,6 +457,12 @@ void *W_CacheLumpNum(int lumpnum, int tag)
     {
         // Not yet loaded, so load it now
 
+        if (lumppurged[lumpnum >> 3] & (1 << (lumpnum & 7)))
+        {
+            Z_NoteReread(W_LumpLength(lumpnum));
+            lumppurged[lumpnum >> 3] &= ~(1 << (lumpnum & 7));
+        }
+
         lump->cache = Z_Malloc(W_LumpLength(lumpnum), tag, &lump->cache);
 	W_ReadLump (lumpnum, lump->cache);
         result = lump->cache;
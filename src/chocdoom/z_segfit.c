@@ -0,0 +1,749 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Zone Memory Allocation with segregated free lists.
+//	 A drop-in replacement for z_zone.c; link one or the other.
+//
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "z_zone.h"
+#include "i_system.h"
+#include "doomtype.h"
+
+
+//
+// ZONE MEMORY ALLOCATION
+//
+// The blocks still tile the zone without gaps, but instead of
+//  a list of all blocks each one records its own size and the
+//  size of the block before it, so the neighbours of a block
+//  are found without a walk.
+//
+// Free blocks are kept in lists by size. Blocks up to 512 bytes
+//  have a list for each size, so a small allocation is a pop.
+//  Bigger blocks share a list per eighth of a power of two.
+//  A bitmap of the lists that are not empty finds the next
+//  bigger one at once, and only when there is none is the
+//  list of the size itself searched.
+//
+// Purgable blocks are kept in least recently used order, the
+//  oldest first. A block moves to the end whenever its tag is
+//  set again, which W_CacheLumpNum does on every use.
+//
+
+#define BLOCKALIGN	8		// a multiple of MEM_ALIGN
+#define ZONEID		0x1d4a11
+
+#define SMALLBINS	64		// one per 8 bytes up to 512
+#define SMALLLIMIT	(SMALLBINS * BLOCKALIGN)
+#define SMALLSHIFT	9		// log2 (SMALLLIMIT)
+#define SUBBINSHIFT	3		// eight lists per power of two above
+#define NUMBINS		(SMALLBINS + ((32 - SMALLSHIFT) << SUBBINSHIFT))
+#define BINWORDS	((NUMBINS + 31) / 32)
+
+typedef struct memblock_s
+{
+    int			size;		// including the header
+    int			prevsize;	// of the block before, 0 for the first
+    void**		user;
+    int			tag;		// PU_FREE if this is free
+    int			id;		// should be ZONEID
+    struct memblock_s*	next;	// in its free list or the purge list
+    struct memblock_s*	prev;
+} memblock_t;
+
+#define HEADERSIZE	((sizeof(memblock_t) + BLOCKALIGN - 1) & ~(BLOCKALIGN - 1))
+#define NEXTBLOCK(b)	((memblock_t *) ((byte *)(b) + (b)->size))
+#define PREVBLOCK(b)	((memblock_t *) ((byte *)(b) - (b)->prevsize))
+#define PURGABLE(b)	((b)->tag >= PU_PURGELEVEL)
+
+
+typedef struct
+{
+    // total bytes malloced, including header
+    int		size;
+
+    memblock_t*	bins[NUMBINS];
+    unsigned	binmap[BINWORDS];
+
+    // start / end cap for the purge list
+    memblock_t	purgelist;
+
+    // the first block, and a static block of no size past the last
+    memblock_t*	first;
+    memblock_t*	last;
+
+} memzone_t;
+
+
+
+memzone_t*	mainzone;
+
+
+
+//
+// Z_SizeBin
+// Returns the free list for blocks of the given size.
+//
+static int Z_SizeBin (int size)
+{
+    int		log;
+
+    if (size <= SMALLLIMIT)
+	return size / BLOCKALIGN - 1;
+
+    log = 31 - __builtin_clz (size);
+
+    return SMALLBINS + ((log - SMALLSHIFT) << SUBBINSHIFT)
+	 + ((size >> (log - SUBBINSHIFT)) & ((1 << SUBBINSHIFT) - 1));
+}
+
+
+//
+// Z_LinkFree
+// Z_UnlinkFree
+//
+static void Z_LinkFree (memblock_t* block)
+{
+    int		bin;
+
+    bin = Z_SizeBin (block->size);
+
+    block->tag = PU_FREE;
+    block->user = NULL;
+    block->id = 0;
+    block->prev = NULL;
+    block->next = mainzone->bins[bin];
+
+    if (block->next)
+	block->next->prev = block;
+
+    mainzone->bins[bin] = block;
+    mainzone->binmap[bin >> 5] |= 1u << (bin & 31);
+}
+
+static void Z_UnlinkFree (memblock_t* block)
+{
+    int		bin;
+
+    bin = Z_SizeBin (block->size);
+
+    if (block->prev)
+	block->prev->next = block->next;
+    else
+	mainzone->bins[bin] = block->next;
+
+    if (block->next)
+	block->next->prev = block->prev;
+
+    if (!mainzone->bins[bin])
+	mainzone->binmap[bin >> 5] &= ~(1u << (bin & 31));
+}
+
+
+//
+// Z_LinkPurgable
+// Z_UnlinkPurgable
+// New and touched blocks go to the end of the purge list.
+//
+static void Z_LinkPurgable (memblock_t* block)
+{
+    block->next = &mainzone->purgelist;
+    block->prev = mainzone->purgelist.prev;
+    block->prev->next = block;
+    mainzone->purgelist.prev = block;
+}
+
+static void Z_UnlinkPurgable (memblock_t* block)
+{
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+    block->next = block->prev = NULL;
+}
+
+
+//
+// Z_FirstBin
+// Returns the first free list from bin on that is not empty,
+//  or -1 if there is none.
+//
+static int Z_FirstBin (int bin)
+{
+    unsigned	bits;
+    int		word;
+
+    if (bin >= NUMBINS)
+	return -1;
+
+    word = bin >> 5;
+    bits = mainzone->binmap[word] & (~0u << (bin & 31));
+
+    while (!bits)
+    {
+	if (++word == BINWORDS)
+	    return -1;
+
+	bits = mainzone->binmap[word];
+    }
+
+    return (word << 5) + __builtin_ctz (bits);
+}
+
+
+//
+// Z_Init
+//
+void Z_Init (void)
+{
+    memblock_t*	block;
+    byte*	base;
+    byte*	end;
+    int		size;
+
+    mainzone = (memzone_t *)I_ZoneBase (&size);
+    memset (mainzone, 0, sizeof(memzone_t));
+    mainzone->size = size;
+
+    mainzone->purgelist.next =
+	mainzone->purgelist.prev = &mainzone->purgelist;
+    mainzone->purgelist.tag = PU_STATIC;
+
+    base = (byte *)mainzone + sizeof(memzone_t);
+    base = (byte *) (((uintptr_t)base + BLOCKALIGN - 1) & ~(uintptr_t)(BLOCKALIGN - 1));
+    end = (byte *)mainzone + size - HEADERSIZE;
+    end = (byte *) ((uintptr_t)end & ~(uintptr_t)(BLOCKALIGN - 1));
+
+    // the end cap is never freed, so nothing merges past it
+    mainzone->last = (memblock_t *)end;
+    mainzone->last->size = 0;
+    mainzone->last->prevsize = end - base;
+    mainzone->last->user = NULL;
+    mainzone->last->tag = PU_STATIC;
+    mainzone->last->id = ZONEID;
+
+    // free block
+    block = mainzone->first = (memblock_t *)base;
+    block->size = end - base;
+    block->prevsize = 0;
+
+    Z_LinkFree (block);
+
+    zonestats.bytes[PU_FREE] = block->size;
+}
+
+
+//
+// Z_FreeBlock
+// Returns the free block the given one was merged into.
+//
+static memblock_t* Z_FreeBlock (memblock_t* block)
+{
+    memblock_t*		other;
+
+    Z_TallyBlock (block->tag, PU_FREE, block->size);
+
+    if (block->user != NULL)
+    {
+    	// clear the user's mark
+	*block->user = 0;
+    }
+
+    if (PURGABLE (block))
+	Z_UnlinkPurgable (block);
+
+    if (block->prevsize)
+    {
+	other = PREVBLOCK (block);
+
+	if (other->tag == PU_FREE)
+	{
+	    // merge with previous free block
+	    Z_UnlinkFree (other);
+	    other->size += block->size;
+	    block = other;
+	}
+    }
+
+    other = NEXTBLOCK (block);
+
+    if (other->tag == PU_FREE)
+    {
+	// merge the next free block onto the end
+	Z_UnlinkFree (other);
+	block->size += other->size;
+    }
+
+    NEXTBLOCK (block)->prevsize = block->size;
+
+    Z_LinkFree (block);
+
+    return block;
+}
+
+
+//
+// Z_Free
+//
+void Z_Free (void* ptr)
+{
+    memblock_t*		block;
+
+    block = (memblock_t *) ( (byte *)ptr - HEADERSIZE);
+
+    if (block->id != ZONEID)
+	I_Error ("Z_Free: freed a pointer without ZONEID");
+
+    Z_Trace ("f %p", ptr);
+
+    Z_FreeBlock (block);
+}
+
+
+//
+// Z_FindFree
+// Returns a free block of at least size bytes, or NULL.
+//
+static memblock_t* Z_FindFree (int size)
+{
+    memblock_t*	block;
+    int		bin;
+    int		next;
+
+    bin = Z_SizeBin (size);
+
+    // every block in a later list is big enough, and so is every
+    //  block in a small one
+    next = Z_FirstBin (bin >= SMALLBINS ? bin + 1 : bin);
+
+    if (next >= 0)
+	return mainzone->bins[next];
+
+    // the blocks in a shared list can be too small
+    for (block = mainzone->bins[bin]; block; block = block->next)
+    {
+	if (block->size >= size)
+	    return block;
+    }
+
+    return NULL;
+}
+
+
+//
+// Z_Purge
+// Throws out purgable blocks, the least recently used first,
+//  until a free block of at least size bytes comes up.
+//
+static memblock_t* Z_Purge (int size)
+{
+    memblock_t*	block;
+    memblock_t*	other;
+
+    while (mainzone->purgelist.next != &mainzone->purgelist)
+    {
+	block = mainzone->purgelist.next;
+
+	Z_NotePurge ((byte *)block + HEADERSIZE, block->size, block->user);
+
+	block = Z_FreeBlock (block);
+
+	// one old block is rarely enough on its own, so take
+	//  its purgable neighbours too before looking further
+	while (block->size < size)
+	{
+	    other = NEXTBLOCK (block);
+
+	    if (!PURGABLE (other) && block->prevsize)
+		other = PREVBLOCK (block);
+
+	    if (!PURGABLE (other))
+		break;
+
+	    Z_NotePurge ((byte *)other + HEADERSIZE, other->size,
+			 other->user);
+
+	    block = Z_FreeBlock (other);
+	}
+
+	if (block->size >= size)
+	    return block;
+    }
+
+    return NULL;
+}
+
+
+//
+// Z_Malloc
+// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+//
+#define MINFRAGMENT		64
+
+
+void*
+Z_Malloc
+( int		size,
+  int		tag,
+  void*		user )
+{
+    int		extra;
+    memblock_t* base;
+    memblock_t* newblock;
+    void *result;
+
+    if (user == NULL && tag >= PU_PURGELEVEL)
+	I_Error ("Z_Malloc: an owner is required for purgable blocks");
+
+    // account for size of block header
+    size = (size + HEADERSIZE + BLOCKALIGN - 1) & ~(BLOCKALIGN - 1);
+
+    base = Z_FindFree (size);
+
+    if (!base)
+	base = Z_Purge (size);
+
+    if (!base)
+	I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+
+    Z_UnlinkFree (base);
+
+    // found a block big enough
+    extra = base->size - size;
+
+    if (extra > MINFRAGMENT)
+    {
+	// there will be a free fragment after the allocated block
+	newblock = (memblock_t *) ((byte *)base + size);
+	newblock->size = extra;
+	newblock->prevsize = size;
+	NEXTBLOCK (newblock)->prevsize = extra;
+
+	Z_LinkFree (newblock);
+
+	base->size = size;
+    }
+
+    base->user = user;
+    base->tag = tag;
+    base->id = ZONEID;
+
+    Z_TallyBlock (PU_FREE, tag, base->size);
+    base->next = base->prev = NULL;
+
+    if (PURGABLE (base))
+	Z_LinkPurgable (base);
+
+    result = (void *) ((byte *)base + HEADERSIZE);
+
+    if (base->user)
+    {
+	*base->user = result;
+    }
+
+    Z_Trace ("m %p %i %i %p",
+	     result, size - (int) HEADERSIZE, tag, user);
+
+    return result;
+}
+
+
+
+//
+// Z_FreeTags
+//
+void
+Z_FreeTags
+( int		lowtag,
+  int		hightag )
+{
+    memblock_t*	block;
+
+    Z_Trace ("x %i %i", lowtag, hightag);
+
+    for (block = mainzone->first;
+	 block != mainzone->last;
+	 block = NEXTBLOCK (block))
+    {
+	// free block?
+	if (block->tag == PU_FREE)
+	    continue;
+
+	if (block->tag >= lowtag && block->tag <= hightag)
+	    block = Z_FreeBlock (block);
+    }
+
+    Z_EmptySlabPools (lowtag, hightag);
+}
+
+
+
+//
+// Z_BlockError
+// Returns what is wrong with a block and the link to the next.
+//
+static char* Z_BlockError (memblock_t* block)
+{
+    memblock_t*	next;
+
+    next = NEXTBLOCK (block);
+
+    if (block->size < (int) HEADERSIZE
+     || (byte *)next > (byte *)mainzone->last)
+	return "block size does not touch the next block";
+
+    if (next->prevsize != block->size)
+	return "next block doesn't have proper back link";
+
+    if (block->tag == PU_FREE && next->tag == PU_FREE)
+	return "two consecutive free blocks";
+
+    if (block->tag != PU_FREE && block->id != ZONEID)
+	return "used block without a ZONEID";
+
+    return NULL;
+}
+
+
+//
+// Z_DumpHeap
+// Note: TFileDumpHeap( stdout ) ?
+//
+void
+Z_DumpHeap
+( int		lowtag,
+  int		hightag )
+{
+    memblock_t*	block;
+    char*	error;
+
+    printf ("zone size: %i  location: %p\n",
+	    mainzone->size,mainzone);
+
+    printf ("tag range: %i to %i\n",
+	    lowtag, hightag);
+
+    for (block = mainzone->first;
+	 block != mainzone->last;
+	 block = NEXTBLOCK (block))
+    {
+	if (block->tag >= lowtag && block->tag <= hightag)
+	    printf ("block:%p    size:%7i    user:%p    tag:%3i\n",
+		    block, block->size, block->user, block->tag);
+
+	error = Z_BlockError (block);
+
+	if (error)
+	{
+	    printf ("ERROR: %s\n", error);
+	    break;
+	}
+    }
+}
+
+
+//
+// Z_FileDumpHeap
+//
+void Z_FileDumpHeap (FILE* f)
+{
+    memblock_t*	block;
+    char*	error;
+
+    fprintf (f,"zone size: %i  location: %p\n",mainzone->size,mainzone);
+
+    for (block = mainzone->first;
+	 block != mainzone->last;
+	 block = NEXTBLOCK (block))
+    {
+	fprintf (f,"block:%p    size:%7i    user:%p    tag:%3i\n",
+		 block, block->size, block->user, block->tag);
+
+	error = Z_BlockError (block);
+
+	if (error)
+	{
+	    fprintf (f,"ERROR: %s\n", error);
+	    break;
+	}
+    }
+}
+
+
+
+//
+// Z_CheckHeap
+// Also checks that every free block is in the right list and
+//  every purgable block in the purge list.
+//
+void Z_CheckHeap (void)
+{
+    memblock_t*	block;
+    char*	error;
+    int		freeblocks;
+    int		purgable;
+    int		bin;
+
+    freeblocks = purgable = 0;
+
+    for (block = mainzone->first;
+	 block != mainzone->last;
+	 block = NEXTBLOCK (block))
+    {
+	error = Z_BlockError (block);
+
+	if (error)
+	    I_Error ("Z_CheckHeap: %s\n", error);
+
+	if (block->tag == PU_FREE)
+	    freeblocks++;
+	else if (PURGABLE (block))
+	    purgable++;
+    }
+
+    for (bin = 0; bin < NUMBINS; bin++)
+    {
+	if (!mainzone->bins[bin] != !(mainzone->binmap[bin >> 5] & (1u << (bin & 31))))
+	    I_Error ("Z_CheckHeap: free list map is out of date\n");
+
+	for (block = mainzone->bins[bin]; block; block = block->next)
+	{
+	    if (block->tag != PU_FREE || Z_SizeBin (block->size) != bin)
+		I_Error ("Z_CheckHeap: block in the wrong free list\n");
+
+	    freeblocks--;
+	}
+    }
+
+    for (block = mainzone->purgelist.next;
+	 block != &mainzone->purgelist;
+	 block = block->next)
+    {
+	if (!PURGABLE (block) || block->next->prev != block)
+	    I_Error ("Z_CheckHeap: broken purge list\n");
+
+	purgable--;
+    }
+
+    if (freeblocks || purgable)
+	I_Error ("Z_CheckHeap: free or purge list is missing blocks\n");
+}
+
+
+
+
+//
+// Z_ChangeTag
+//
+void Z_ChangeTag2(void *ptr, int tag, char *file, int line)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ((byte *)ptr - HEADERSIZE);
+
+    if (block->id != ZONEID)
+        I_Error("%s:%i: Z_ChangeTag: block without a ZONEID!",
+                file, line);
+
+    if (tag >= PU_PURGELEVEL && block->user == NULL)
+        I_Error("%s:%i: Z_ChangeTag: an owner is required "
+                "for purgable blocks", file, line);
+
+    Z_Trace ("t %p %i", ptr, tag);
+
+    if (PURGABLE (block))
+	Z_UnlinkPurgable (block);
+
+    Z_TallyBlock (block->tag, tag, block->size);
+
+    block->tag = tag;
+
+    if (PURGABLE (block))
+	Z_LinkPurgable (block);
+}
+
+void Z_ChangeUser(void *ptr, void **user)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ((byte *)ptr - HEADERSIZE);
+
+    if (block->id != ZONEID)
+    {
+        I_Error("Z_ChangeUser: Tried to change user for invalid block!");
+    }
+
+    Z_Trace ("u %p %p", ptr, user);
+
+    block->user = user;
+    *user = ptr;
+}
+
+
+
+//
+// Z_FreeMemory
+//
+int Z_FreeMemory (void)
+{
+    memblock_t*		block;
+    int			free;
+
+    free = 0;
+
+    for (block = mainzone->first;
+         block != mainzone->last;
+         block = NEXTBLOCK (block))
+    {
+        if (block->tag == PU_FREE || block->tag >= PU_PURGELEVEL)
+            free += block->size;
+    }
+
+    return free;
+}
+
+unsigned int Z_ZoneSize(void)
+{
+    return mainzone->size;
+}
+
+
+
+//
+// Z_UpdateStats
+// The free lists hold every free block.
+//
+void Z_UpdateStats (void)
+{
+    memblock_t*		block;
+    int			bin;
+
+    zonestats.blocks[PU_FREE] = 0;
+    zonestats.largestfree = 0;
+
+    for (bin = 0; bin < NUMBINS; bin++)
+    {
+	for (block = mainzone->bins[bin]; block; block = block->next)
+	{
+	    zonestats.blocks[PU_FREE]++;
+
+	    if (block->size > zonestats.largestfree)
+		zonestats.largestfree = block->size;
+	}
+    }
+}
+
@@ -0,0 +1,178 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Slab pools of fixed-size objects on top of the zone.
+//
+
+
+#include "z_zone.h"
+#include "doomtype.h"
+
+
+//
+// SLAB POOLS
+//
+// Each object is preceded by one word, holding its pool while it
+//  is handed out and the next free object while it is not.
+//
+#define SLABBLOCKSIZE	4096
+
+typedef union slabobject_u
+{
+    slabpool_t*		pool;
+    union slabobject_u*	next;
+
+} slabobject_t;
+
+static slabpool_t*	slabpools;
+
+static int Z_SlabStride (slabpool_t* pool)
+{
+    return sizeof(slabobject_t) + ((pool->size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1));
+}
+
+
+//
+// Z_RegisterSlabPool
+// Lists the pool for Z_EmptySlabPools and Z_PrintSlabStats.
+//
+static void Z_RegisterSlabPool (slabpool_t* pool)
+{
+    if (!pool->registered)
+    {
+	pool->registered = true;
+	pool->next = slabpools;
+	slabpools = pool;
+    }
+}
+
+
+//
+// Z_GrowSlabPool
+// Takes a zone block for another batch of objects.
+//
+static void Z_GrowSlabPool (slabpool_t* pool)
+{
+    slabobject_t*	obj;
+    byte*		block;
+    int			stride;
+    int			count;
+    int			i;
+
+    Z_RegisterSlabPool (pool);
+
+    stride = Z_SlabStride (pool);
+    count = SLABBLOCKSIZE / stride;
+
+    if (count < 1)
+	count = 1;
+
+    block = Z_Malloc (count * stride, pool->tag, NULL);
+
+    for (i = count - 1; i >= 0; i--)
+    {
+	obj = (slabobject_t *) (block + i * stride);
+	obj->next = pool->freelist;
+	pool->freelist = obj;
+    }
+}
+
+
+//
+// Z_SlabAlloc
+//
+void* Z_SlabAlloc (slabpool_t* pool)
+{
+    slabobject_t*	obj;
+
+    if (pool->zoneblocks)
+    {
+	Z_RegisterSlabPool (pool);
+	obj = Z_Malloc (Z_SlabStride (pool), pool->tag, NULL);
+    }
+    else
+    {
+	if (!pool->freelist)
+	    Z_GrowSlabPool (pool);
+
+	obj = pool->freelist;
+	pool->freelist = obj->next;
+    }
+
+    obj->pool = pool;
+
+    if (++pool->live > pool->peak)
+	pool->peak = pool->live;
+
+    return obj + 1;
+}
+
+
+//
+// Z_SlabFree
+//
+void Z_SlabFree (void* ptr)
+{
+    slabobject_t*	obj;
+    slabpool_t*		pool;
+
+    obj = (slabobject_t *) ptr - 1;
+    pool = obj->pool;
+    pool->live--;
+
+    if (pool->zoneblocks)
+    {
+	Z_Free (obj);
+	return;
+    }
+
+    obj->next = pool->freelist;
+    pool->freelist = obj;
+}
+
+
+//
+// Z_EmptySlabPools
+// Called by Z_FreeTags once the blocks of the pools with a tag
+//  in the range are gone.
+//
+void Z_EmptySlabPools (int lowtag, int hightag)
+{
+    slabpool_t*		pool;
+
+    for (pool = slabpools; pool; pool = pool->next)
+    {
+	if (pool->tag >= lowtag && pool->tag <= hightag)
+	{
+	    pool->freelist = NULL;
+	    pool->live = 0;
+	}
+    }
+}
+
+
+//
+// Z_PrintSlabStats
+//
+void Z_PrintSlabStats (void)
+{
+    slabpool_t*		pool;
+
+    for (pool = slabpools; pool; pool = pool->next)
+    {
+	printf ("%s: %i live, %i peak, %i bytes each\n",
+		pool->name, pool->live, pool->peak, Z_SlabStride (pool));
+    }
+}
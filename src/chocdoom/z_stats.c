@@ -0,0 +1,170 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Zone telemetry shared by the zone backends.
+//
+
+
+#include <stdarg.h>
+
+#include "z_zone.h"
+#include "i_timer.h"
+#include "doomtype.h"
+
+
+zonestats_t	zonestats;
+
+// tics between reports on the debug UART, 0 for none
+int		zone_stats_tics = 0;
+
+// if non-zero, every zone operation is printed on the debug UART
+int		zone_trace = 0;
+
+static void	(*purgehook) (void** user);
+
+// bytes that cannot be purged
+#define HELD(tag)	((tag) != PU_FREE && (tag) < PU_PURGELEVEL)
+
+static const char* tagnames[PU_NUM_TAGS] =
+{
+    NULL, "static", "sound", "music", "free",
+    "level", "levspec", "purgelevel", "cache"
+};
+
+
+//
+// Z_TallyBlock
+// Moves a block of size bytes from one tag to another. Free
+//  blocks are counted by Z_UpdateStats instead, as they merge.
+//
+void Z_TallyBlock (int fromtag, int totag, int size)
+{
+    zonestats.bytes[fromtag] -= size;
+    zonestats.bytes[totag] += size;
+
+    if (fromtag != PU_FREE)
+	zonestats.blocks[fromtag]--;
+
+    if (totag != PU_FREE)
+	zonestats.blocks[totag]++;
+
+    if (zonestats.bytes[totag] > zonestats.peakbytes[totag])
+	zonestats.peakbytes[totag] = zonestats.bytes[totag];
+
+    if (HELD (fromtag))
+	zonestats.held -= size;
+
+    if (HELD (totag))
+	zonestats.held += size;
+
+    if (zonestats.held > zonestats.peakheld)
+	zonestats.peakheld = zonestats.held;
+}
+
+
+//
+// Z_SetPurgeHook
+//
+void Z_SetPurgeHook (void (*hook) (void** user))
+{
+    purgehook = hook;
+}
+
+
+//
+// Z_NotePurge
+// Called by the backends before they throw out a purgable block.
+//
+void Z_NotePurge (void* ptr, int size, void** user)
+{
+    zonestats.purges++;
+    zonestats.purgedbytes += size;
+
+    Z_Trace ("p %p", ptr);
+
+    if (purgehook)
+	purgehook (user);
+}
+
+
+//
+// Z_Trace
+// Prints one zone operation as a line starting with "Z ", for
+//  test/zone_test to replay:
+//  m <pointer> <size> <tag> <user>	Z_Malloc
+//  f <pointer>				Z_Free
+//  t <pointer> <tag>			Z_ChangeTag
+//  u <pointer> <user>			Z_ChangeUser
+//  x <lowtag> <hightag>		Z_FreeTags
+//  p <pointer>				purged to make room
+//
+void Z_Trace (char* format, ...)
+{
+    va_list	args;
+
+    if (!zone_trace)
+	return;
+
+    va_start (args, format);
+    printf ("Z ");
+    vprintf (format, args);
+    printf ("\n");
+    va_end (args);
+}
+
+
+//
+// Z_NoteReread
+// Called when a lump that was purged is read in again.
+//
+void Z_NoteReread (int size)
+{
+    zonestats.rereads++;
+    zonestats.rereadbytes += size;
+}
+
+
+//
+// Z_PrintStats
+// One line, so that a stream of them over the debug UART can be
+//  logged and compared.
+//
+void Z_PrintStats (void)
+{
+    int		free;
+    int		tag;
+
+    Z_UpdateStats ();
+
+    free = zonestats.bytes[PU_FREE];
+
+    printf ("zone ms=%i free=%i/%i largest=%i frag=%i%% held=%i/%i",
+	    I_GetTimeMS (), free, zonestats.blocks[PU_FREE],
+	    zonestats.largestfree,
+	    free ? 100 - (int) ((int64_t) zonestats.largestfree * 100 / free) : 0,
+	    zonestats.held, zonestats.peakheld);
+
+    for (tag = PU_STATIC; tag < PU_NUM_TAGS; tag++)
+    {
+	if (tag != PU_FREE)
+	    printf (" %s=%i/%i/%i", tagnames[tag], zonestats.bytes[tag],
+		    zonestats.blocks[tag], zonestats.peakbytes[tag]);
+    }
+
+    printf (" purged=%u/%u reread=%u/%u\n",
+	    zonestats.purges, zonestats.purgedbytes,
+	    zonestats.rereads, zonestats.rereadbytes);
+}
+
@@ -33,7 +33,6 @@
 //  because it will get overwritten automatically if needed.
 // 
  
-#define MEM_ALIGN sizeof(void *)
 #define ZONEID	0x1d4a11
 
 typedef struct memblock_s
@@ -117,6 +116,8 @@ void Z_Init (void)
     block->tag = PU_FREE;
     
     block->size = mainzone->size - sizeof(memzone_t);
+
+    zonestats.bytes[PU_FREE] = block->size;
 }
 
 
@@ -132,6 +133,11 @@ void Z_Free (void* ptr)
 
     if (block->id != ZONEID)
 	I_Error ("Z_Free: freed a pointer without ZONEID");
+
+    Z_Trace ("f %p", ptr);
+
+    if (block->tag != PU_FREE)
+	Z_TallyBlock (block->tag, PU_FREE, block->size);
 		
     if (block->tag != PU_FREE && block->user != NULL)
     {
@@ -234,6 +240,9 @@ Z_Malloc
             {
                 // free the rover block (adding the size to base)
 
+                Z_NotePurge ((byte *)rover+sizeof(memblock_t),
+                             rover->size, rover->user);
+
                 // the rover can be the base block
                 base = base->prev;
                 Z_Free ((byte *)rover+sizeof(memblock_t));
@@ -274,6 +283,8 @@ Z_Malloc
     base->user = user;
     base->tag = tag;
 
+    Z_TallyBlock (PU_FREE, tag, base->size);
+
     result  = (void *) ((byte *)base + sizeof(memblock_t));
 
     if (base->user)
@@ -285,6 +296,9 @@ Z_Malloc
     mainzone->rover = base->next;	
 	
     base->id = ZONEID;
+
+    Z_Trace ("m %p %i %i %p",
+	     result, size - (int) sizeof(memblock_t), tag, user);
     
     return result;
 }
@@ -301,6 +315,8 @@ Z_FreeTags
 {
     memblock_t*	block;
     memblock_t*	next;
+
+    Z_Trace ("x %i %i", lowtag, hightag);
 	
     for (block = mainzone->blocklist.next ;
 	 block != &mainzone->blocklist ;
@@ -316,6 +332,8 @@ Z_FreeTags
 	if (block->tag >= lowtag && block->tag <= hightag)
 	    Z_Free ( (byte *)block+sizeof(memblock_t));
     }
+
+    Z_EmptySlabPools (lowtag, hightag);
 }
 
 
@@ -440,6 +458,10 @@ void Z_ChangeTag2(void *ptr, int tag, char *file, int line)
         I_Error("%s:%i: Z_ChangeTag: an owner is required "
                 "for purgable blocks", file, line);
 
+    Z_Trace ("t %p %i", ptr, tag);
+
+    Z_TallyBlock (block->tag, tag, block->size);
+
     block->tag = tag;
 }
 
@@ -454,6 +476,8 @@ void Z_ChangeUser(void *ptr, void **user)
         I_Error("Z_ChangeUser: Tried to change user for invalid block!");
     }
 
+    Z_Trace ("u %p %p", ptr, user);
+
     block->user = user;
     *user = ptr;
 }
@@ -486,3 +510,29 @@ unsigned int Z_ZoneSize(void)
     return mainzone->size;
 }
 
+
+
+//
+// Z_UpdateStats
+//
+void Z_UpdateStats (void)
+{
+    memblock_t*		block;
+
+    zonestats.blocks[PU_FREE] = 0;
+    zonestats.largestfree = 0;
+
+    for (block = mainzone->blocklist.next ;
+         block != &mainzone->blocklist;
+         block = block->next)
+    {
+        if (block->tag != PU_FREE)
+            continue;
+
+        zonestats.blocks[PU_FREE]++;
+
+        if (block->size > zonestats.largestfree)
+            zonestats.largestfree = block->size;
+    }
+}
+
@@ -26,6 +26,9 @@
 
 #include <stdio.h>
 
+// zone blocks and slab objects are aligned to this
+#define MEM_ALIGN sizeof(void *)
+
 //
 // ZONE MEMORY
 // PU - purge tags.
@@ -62,6 +65,71 @@ void    Z_ChangeUser(void *ptr, void **user);
 int     Z_FreeMemory (void);
 unsigned int Z_ZoneSize(void);
 
+//
+// Slab pools hand out objects of one size, carved from zone blocks
+//  with the pool's tag, and take them back onto a free list.
+//  Z_FreeTags empties the pools along with their blocks.
+//  A pool of zone blocks gives every object a block of its own and
+//  frees it at once, so the zone decides when its memory is reused.
+//
+typedef struct slabpool_s
+{
+    const char*		name;
+    int			size;
+    int			tag;
+    int			zoneblocks;
+
+    void*		freelist;
+    int			live;		// objects handed out
+    int			peak;		// most objects handed out at once
+    int			registered;
+    struct slabpool_s*	next;
+
+} slabpool_t;
+
+void*	Z_SlabAlloc (slabpool_t* pool);
+void	Z_SlabFree (void* ptr);
+void	Z_PrintSlabStats (void);
+void	Z_EmptySlabPools (int lowtag, int hightag);	// from Z_FreeTags
+
+//
+// Zone telemetry. The counts by tag are kept up to date as blocks
+//  come and go; Z_UpdateStats fills in the free blocks, which
+//  needs a walk of the zone.
+//
+typedef struct
+{
+    int		bytes[PU_NUM_TAGS];	// including the headers
+    int		blocks[PU_NUM_TAGS];
+    int		peakbytes[PU_NUM_TAGS];
+
+    int		held;			// bytes in blocks that cannot be purged
+    int		peakheld;
+    int		largestfree;
+
+    unsigned	purges;			// purgable blocks thrown out
+    unsigned	purgedbytes;
+    unsigned	rereads;		// lumps read again after a purge
+    unsigned	rereadbytes;
+
+} zonestats_t;
+
+extern zonestats_t	zonestats;
+extern int		zone_stats_tics;
+extern int		zone_trace;
+
+void	Z_UpdateStats (void);
+void	Z_PrintStats (void);
+void	Z_NoteReread (int size);
+
+// Called with the user of each block purged, before it is cleared.
+void	Z_SetPurgeHook (void (*hook) (void** user));
+
+// from the backends
+void	Z_TallyBlock (int fromtag, int totag, int size);
+void	Z_NotePurge (void* ptr, int size, void** user);
+void	Z_Trace (char* format, ...);
+
 //
 // This is used to get the local FILE:LINE info from CPP
 // prior to really call the function in question.
@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "stm32f4xx.h"
 #include "gfx.h"
 #include "lcd.h"
@@ -76,6 +77,9 @@
 /* layer size */
 #define LCD_FRAME_SIZE				((uint32_t)(LCD_MAX_X * LCD_MAX_Y * 2))
 
+/* address of frame buffer n */
+#define LCD_FRAME_ADDRESS(n)		(LCD_FRAME_BUFFER + (n) * LCD_FRAME_SIZE)
+
 /*---------------------------------------------------------------------*
  *  external declarations                                              *
  *---------------------------------------------------------------------*/
@@ -99,12 +103,43 @@ lcd_layers_t lcd_layer;
  */
 bool lcd_vsync;
 
+/*
+ * number of frame buffers in rotation: 2 layers, or 3 with lcd_flip
+ */
+uint8_t lcd_frame_buffers = 2;
+
+/*
+ * cycles spent in lcd_flip waiting for the previous flip to complete
+ */
+uint64_t lcd_flip_wait_cycles;
+
+/*
+ * number of calls to lcd_flip that had to wait
+ */
+uint32_t lcd_flip_waits;
+
 /*---------------------------------------------------------------------*
  *  private data                                                       *
  *---------------------------------------------------------------------*/
 
 static volatile bool lcd_refreshed;
 
+/* triple buffering: buffer being scanned out, buffer queued for the
+ * next vertical blank (-1 if none) and buffer being drawn to */
+static volatile uint8_t lcd_displayed;
+static volatile int8_t lcd_pending = -1;
+static uint8_t lcd_drawing;
+
+/* addresses of the buffers switched by lcd_flip */
+static uint32_t lcd_flip_buffers[LCD_FRAME_BUFFERS];
+
+/* color look-up table of the indexed layer, queued by lcd_flip and
+ * written to the LTDC in the vertical blank by the interrupt handler */
+static uint32_t lcd_clut[256];
+static uint32_t lcd_clut_queued[256];
+static bool lcd_clut_changed;
+static volatile bool lcd_clut_pending;
+
 /*---------------------------------------------------------------------*
  *  private functions                                                  *
  *---------------------------------------------------------------------*/
@@ -497,7 +532,7 @@ static void lcd_layer_fullscreen (void)
 	LTDC_LayerInit (LTDC_Layer1, &LTDC_Layer_InitStruct);
 
 	// foreground layer
-	LTDC_Layer_InitStruct.LTDC_CFBStartAdress = LCD_FRAME_BUFFER + LCD_FRAME_SIZE;
+	LTDC_Layer_InitStruct.LTDC_CFBStartAdress = LCD_FRAME_ADDRESS (1);
 	LTDC_LayerInit (LTDC_Layer2, &LTDC_Layer_InitStruct);
 
 	LTDC_ReloadConfig (LTDC_IMReload);
@@ -575,7 +610,7 @@ void lcd_set_layer (lcd_layers_t layer)
 			break;
 
 		case LCD_FOREGROUND:
-			lcd_frame_buffer = LCD_FRAME_BUFFER + LCD_FRAME_SIZE;
+			lcd_frame_buffer = LCD_FRAME_ADDRESS (1);
 			lcd_layer = LCD_FOREGROUND;
 			break;
 
@@ -625,11 +660,241 @@ void lcd_set_transparency (lcd_layers_t layer, uint8_t transparency)
 	}
 }
 
+/*
+ * Switch to triple buffering with lcd_flip
+ *
+ * Only the background layer is displayed from now on and its frame
+ * buffer address is switched between three buffers. The third buffer
+ * starts as a copy of the currently visible layer.
+ *
+ * The foreground layer is disabled. With lcd_refresh it is the second
+ * page, not an overlay: what was drawn to both layers before, like the
+ * touch keys, is in all three buffers and stays visible. Anything drawn
+ * to only one layer, or after this call, is not.
+ */
+void lcd_triple_buffer_init (void)
+{
+	uint8_t i;
+
+	for (i = 0; i < LCD_FRAME_BUFFERS; i++)
+	{
+		lcd_flip_buffers[i] = LCD_FRAME_ADDRESS (i);
+	}
+
+	// the invisible layer is the one being drawn to
+	lcd_displayed = (lcd_layer == LCD_FOREGROUND) ? 0 : 1;
+	lcd_drawing = 2;
+	lcd_pending = -1;
+
+	memcpy ((void*)LCD_FRAME_ADDRESS (lcd_drawing), (void*)LCD_FRAME_ADDRESS (lcd_displayed), LCD_FRAME_SIZE);
+
+	LTDC_LayerAddress (LTDC_Layer1, LCD_FRAME_ADDRESS (lcd_displayed));
+	LTDC_LayerCmd (LTDC_Layer2, DISABLE);
+	LTDC_ReloadConfig (LTDC_IMReload);
+
+	lcd_frame_buffer = lcd_flip_buffers[lcd_drawing];
+	lcd_frame_buffers = LCD_FRAME_BUFFERS;
+
+	// cycle counter for lcd_flip_wait_cycles
+	cycle_counter_init ();
+}
+
+/*
+ * Switch to an 8-bit indexed layer with lcd_flip
+ *
+ * The background layer shows LCD columns x and up from three L8 frame
+ * buffers of (LCD_MAX_X - x) bytes per line, which are switched by
+ * lcd_flip. Their colors are looked up in the CLUT set by lcd_set_clut,
+ * which starts all black. The foreground layer keeps showing columns
+ * 0 to x - 1 of the currently visible RGB565 layer, if x is not 0.
+ *
+ * @param[in]	x	first LCD column of the indexed layer
+ */
+void lcd_indexed_init (uint16_t x)
+{
+	LTDC_Layer_InitTypeDef LTDC_Layer_InitStruct;
+	uint32_t width;
+	uint16_t i;
+
+	width = LCD_MAX_X - x;
+
+	// RGB565 part stays in the first buffer, the L8 buffers follow it
+	if (lcd_layer == LCD_BACKGROUND)
+	{
+		memcpy ((void*)LCD_FRAME_ADDRESS (0), (void*)LCD_FRAME_ADDRESS (1), LCD_FRAME_SIZE);
+	}
+
+	for (i = 0; i < LCD_FRAME_BUFFERS; i++)
+	{
+		lcd_flip_buffers[i] = LCD_FRAME_ADDRESS (1) + i * width * LCD_MAX_Y;
+		memset ((void*)lcd_flip_buffers[i], 0, width * LCD_MAX_Y);
+	}
+
+	lcd_displayed = 0;
+	lcd_drawing = 1;
+	lcd_pending = -1;
+
+	LTDC_LayerCmd (LTDC_Layer1, DISABLE);
+	LTDC_LayerCmd (LTDC_Layer2, DISABLE);
+	LTDC_ReloadConfig (LTDC_IMReload);
+
+	// background layer: indexed part
+	LTDC_Layer_InitStruct.LTDC_HorizontalStart = 30 + x;
+	LTDC_Layer_InitStruct.LTDC_HorizontalStop = LCD_MAX_X + 30 - 1;
+	LTDC_Layer_InitStruct.LTDC_VerticalStart = 4;
+	LTDC_Layer_InitStruct.LTDC_VerticalStop = LCD_MAX_Y + 4 - 1;
+
+	LTDC_Layer_InitStruct.LTDC_PixelFormat = LTDC_Pixelformat_L8;
+	LTDC_Layer_InitStruct.LTDC_ConstantAlpha = 0xFF; // opaque
+	LTDC_Layer_InitStruct.LTDC_DefaultColorBlue = 0;
+	LTDC_Layer_InitStruct.LTDC_DefaultColorGreen = 0;
+	LTDC_Layer_InitStruct.LTDC_DefaultColorRed = 0;
+	LTDC_Layer_InitStruct.LTDC_DefaultColorAlpha = 0;
+
+	LTDC_Layer_InitStruct.LTDC_CFBLineLength = width + 3;
+	LTDC_Layer_InitStruct.LTDC_CFBPitch = width;
+	LTDC_Layer_InitStruct.LTDC_CFBLineNumber = LCD_MAX_Y;
+
+	LTDC_Layer_InitStruct.LTDC_CFBStartAdress = lcd_flip_buffers[lcd_displayed];
+	LTDC_Layer_InitStruct.LTDC_BlendingFactor_1 = LTDC_BlendingFactor1_CA;
+	LTDC_Layer_InitStruct.LTDC_BlendingFactor_2 = LTDC_BlendingFactor2_CA;
+	LTDC_LayerInit (LTDC_Layer1, &LTDC_Layer_InitStruct);
+
+	// foreground layer: RGB565 part, if any
+	LTDC_Layer_InitStruct.LTDC_HorizontalStart = 30;
+	LTDC_Layer_InitStruct.LTDC_HorizontalStop = x + 30 - 1;
+	LTDC_Layer_InitStruct.LTDC_PixelFormat = LTDC_Pixelformat_RGB565;
+	LTDC_Layer_InitStruct.LTDC_CFBLineLength = (x * 2) + 3;
+	LTDC_Layer_InitStruct.LTDC_CFBPitch = LCD_MAX_X * 2;
+	LTDC_Layer_InitStruct.LTDC_CFBStartAdress = LCD_FRAME_ADDRESS (0);
+
+	if (x > 0)
+	{
+		LTDC_LayerInit (LTDC_Layer2, &LTDC_Layer_InitStruct);
+	}
+
+	// the CLUT may only be written while the layer is disabled or in the
+	// vertical blank
+	for (i = 0; i < 256; i++)
+	{
+		lcd_clut[i] = 0;
+		LTDC_Layer1->CLUTWR = (uint32_t)i << 24;
+	}
+
+	lcd_clut_changed = false;
+	lcd_clut_pending = false;
+
+	LTDC_CLUTCmd (LTDC_Layer1, ENABLE);
+	LTDC_LayerAlpha (LTDC_Layer2, GFX_OPAQUE);
+
+	LTDC_LayerCmd (LTDC_Layer1, ENABLE);
+	LTDC_LayerCmd (LTDC_Layer2, (x > 0) ? ENABLE : DISABLE);
+	LTDC_ReloadConfig (LTDC_IMReload);
+
+	lcd_frame_buffer = lcd_flip_buffers[lcd_drawing];
+	lcd_frame_buffers = LCD_FRAME_BUFFERS;
+
+	// cycle counter for lcd_flip_wait_cycles
+	cycle_counter_init ();
+}
+
+/*
+ * Set the color look-up table of the indexed layer
+ *
+ * The table takes effect together with the next buffer queued by
+ * lcd_flip.
+ *
+ * @param[in]	clut	256 colors, 0x00RRGGBB
+ */
+void lcd_set_clut (const uint32_t* clut)
+{
+	memcpy (lcd_clut, clut, sizeof (lcd_clut));
+
+	lcd_clut_changed = true;
+}
+
+/*
+ * Get a spare buffer of frame size
+ *
+ * The spare buffers follow the frame buffers and are never displayed or
+ * used by this module. They can hold frames to be copied to the frame
+ * buffer.
+ *
+ * @param[in]	n	0 to LCD_SPARE_BUFFERS - 1
+ * @return			address of spare buffer n
+ */
+uint32_t lcd_spare_buffer (uint8_t n)
+{
+	return LCD_FRAME_ADDRESS (LCD_FRAME_BUFFERS + n);
+}
+
+/*
+ * Queue the buffer drawn to for display and return without waiting
+ *
+ * The new buffer is shown at the next vertical blank. Drawing continues
+ * in the buffer that is neither displayed nor queued. Only one flip can
+ * be queued, so this waits if the previous flip has not completed yet.
+ */
+void lcd_flip (void)
+{
+	uint32_t start;
+
+	if (lcd_pending >= 0)
+	{
+		start = DWT->CYCCNT;
+
+		while (lcd_pending >= 0);
+
+		lcd_flip_wait_cycles += DWT->CYCCNT - start;
+		lcd_flip_waits++;
+	}
+
+	if (lcd_clut_changed)
+	{
+		memcpy (lcd_clut_queued, lcd_clut, sizeof (lcd_clut_queued));
+
+		lcd_clut_changed = false;
+		lcd_clut_pending = true;
+	}
+
+	lcd_pending = lcd_drawing;
+
+	LTDC_LayerAddress (LTDC_Layer1, lcd_flip_buffers[lcd_drawing]);
+
+	LTDC_ITConfig (LTDC_IT_RR, ENABLE);
+
+	/* reload shadow register on next vertical blank */
+	LTDC_ReloadConfig (LTDC_VBReload);
+
+	// indices are 0, 1 and 2
+	lcd_drawing = 3 - lcd_displayed - lcd_pending;
+	lcd_frame_buffer = lcd_flip_buffers[lcd_drawing];
+}
+
 void LTDC_IRQHandler (void)
 {
+	uint32_t i;
+
 	LTDC_ClearITPendingBit (LTDC_IT_RR);
 	LTDC_ITConfig (LTDC_IT_RR, DISABLE);
 
+	if (lcd_pending >= 0)
+	{
+		lcd_displayed = lcd_pending;
+		lcd_pending = -1;
+
+		// still in the vertical blank, with the new buffer just loaded
+		if (lcd_clut_pending)
+		{
+			for (i = 0; i < 256; i++)
+			{
+				LTDC_Layer1->CLUTWR = (i << 24) | lcd_clut_queued[i];
+			}
+
+			lcd_clut_pending = false;
+		}
+	}
+
 	lcd_refreshed = true;
 }
 
@@ -23,6 +23,10 @@
 #define LCD_MAX_X					240	// LCD width
 #define LCD_MAX_Y					320 // LCD height
 
+/* memory.ld reserves the start of SDRAM for all of these buffers */
+#define LCD_FRAME_BUFFERS			3	// frame buffers in SDRAM
+#define LCD_SPARE_BUFFERS			2	// buffers of frame size not displayed
+
 /*---------------------------------------------------------------------*
  *  type declarations                                                  *
  *---------------------------------------------------------------------*/
@@ -45,6 +49,16 @@ void lcd_refresh (void);
 
 void lcd_set_transparency (lcd_layers_t layer, uint8_t transparency);
 
+void lcd_triple_buffer_init (void);
+
+void lcd_indexed_init (uint16_t x);
+
+void lcd_set_clut (const uint32_t* clut);
+
+void lcd_flip (void);
+
+uint32_t lcd_spare_buffer (uint8_t n);
+
 /*---------------------------------------------------------------------*
  *  global data                                                        *
  *---------------------------------------------------------------------*/
@@ -55,6 +69,12 @@ extern lcd_layers_t lcd_layer;
 
 extern bool lcd_vsync;
 
+extern uint8_t lcd_frame_buffers;
+
+extern uint64_t lcd_flip_wait_cycles;
+
+extern uint32_t lcd_flip_waits;
+
 /*---------------------------------------------------------------------*
  *  inline functions and function-like macros                          *
  *---------------------------------------------------------------------*/
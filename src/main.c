@@ -184,6 +184,16 @@ void sleep_ms (uint32_t ms)
 	}
 }
 
+/*
+ * Start the DWT cycle counter (CYCCNT), which counts CPU cycles at
+ * 168 MHz for profiling. Enabling it again does not reset it.
+ */
+void cycle_counter_init (void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
 /*
  * System tick interrupt handler
  */
@@ -30,6 +30,8 @@ int main (void);
 
 void sleep_ms (uint32_t ms);
 
+void cycle_counter_init (void);
+
 void fatal_error (const char* message) __attribute__ ((noreturn));
 
 /*---------------------------------------------------------------------*
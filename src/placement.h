@@ -0,0 +1,65 @@
+/*
+ * placement.h
+ *
+ *  Placement manifest: which memory region each hot lookup table
+ *  is linked into. The regions are laid out in memory.ld, and the
+ *  initialized ones are copied from flash by the reset handler.
+ *  "make placement" lists what landed where and what is left.
+ */
+
+
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+/*---------------------------------------------------------------------*
+ *  additional includes                                                *
+ *---------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------*
+ *  global definitions                                                 *
+ *---------------------------------------------------------------------*/
+
+/* regions; a translation unit must not put const and non-const
+   objects into the same one */
+#define PLACE_FLASH							// const data stays in flash
+#define PLACE_CCM		__attribute__ ((section(".ccm")))		// 64K core-coupled RAM, copied from flash
+#define PLACE_CCM_BSS	__attribute__ ((section(".ccm_bss")))	// 64K core-coupled RAM, zeroed
+#define PLACE_SRAM		__attribute__ ((section(".data.sram")))	// SRAM, copied from flash
+#define PLACE_SRAM_BSS	__attribute__ ((section(".bss.sram")))	// SRAM, zeroed
+#define PLACE_SDRAM		__attribute__ ((section(".sdram")))		// external SDRAM, not zeroed
+
+/* manifest; array sizes in bytes, CCM is 65536 and memory.ld fails
+   the link if .ccm and .ccm_bss do not fit. SRAM holds only what was
+   there before, until a linked image shows the stack still fits. */
+#define FINESINE_PLACEMENT		PLACE_CCM		// 40960, tables.c
+#define TANTOANGLE_PLACEMENT	PLACE_CCM		//  8196, tables.c
+#define FINETANGENT_PLACEMENT	PLACE_FLASH		// 16384, tables.c
+#define GAMMATABLE_PLACEMENT	PLACE_FLASH		//  1280, tables.c
+#define COLORMAPS_PLACEMENT		PLACE_CCM_BSS	//  8704, r_data.c
+#define XTOVIEWANGLE_PLACEMENT	PLACE_CCM_BSS	//  1284, r_main.c
+#define LITCOLUMNS_PLACEMENT	PLACE_CCM_BSS	//  5012, r_colcache.c
+#define VIEWANGLETOX_PLACEMENT	PLACE_SDRAM		// 16384, r_main.c
+#define YLOOKUP_PLACEMENT		PLACE_SRAM_BSS	//  3328, r_draw.c
+#define COLUMNOFS_PLACEMENT		PLACE_SRAM_BSS	//  4480, r_draw.c
+
+/*---------------------------------------------------------------------*
+ *  type declarations                                                  *
+ *---------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------*
+ *  function prototypes                                                *
+ *---------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------*
+ *  global data                                                        *
+ *---------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------*
+ *  inline functions and function-like macros                          *
+ *---------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------*
+ *  eof                                                                *
+ *---------------------------------------------------------------------*/
+
+#endif /* PLACEMENT_H_ */
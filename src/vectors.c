@@ -140,6 +140,12 @@ extern unsigned long _sdata;     /*!< Start address for the .data section     */
 extern unsigned long _edata;     /*!< End address for the .data section       */
 extern unsigned long _sbss;      /*!< Start address for the .bss section      */
 extern unsigned long _ebss;      /*!< End address for the .bss section        */
+extern unsigned long _siccm;     /*!< Start address for the initialization
+                                      values of the .ccm section.             */
+extern unsigned long _sccm;      /*!< Start address for the .ccm section      */
+extern unsigned long _eccm;      /*!< End address for the .ccm section        */
+extern unsigned long _sccm_bss;  /*!< Start address for the .ccm_bss section  */
+extern unsigned long _eccm_bss;  /*!< End address for the .ccm_bss section    */
 
 extern int main (void);           /*!< The entry point for the application.    */
 
@@ -301,6 +307,20 @@ void Default_Reset_Handler (void)
 		*(pulDest++) = *(pulSrc++);
 	}
 
+	/* Copy the tables placed in core-coupled RAM from flash (see placement.h) */
+	pulSrc = &_siccm;
+
+	for(pulDest = &_sccm; pulDest < &_eccm; )
+	{
+		*(pulDest++) = *(pulSrc++);
+	}
+
+	/* Zero fill the core-coupled RAM bss */
+	for(pulDest = &_sccm_bss; pulDest < &_eccm_bss; )
+	{
+		*(pulDest++) = 0;
+	}
+
 	/* Zero fill the bss segment. This is done with inline assembly since this
 	 will clear the value of pulDest if it is not kept in a register. */
 	__asm("  ldr     r0, =_sbss\n"
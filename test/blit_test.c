@@ -0,0 +1,256 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the blit engines: every engine must show exactly what
+//	the reference blit shows, for random screens and random dirty
+//	rectangles. Indexed layers are seen through the model of the CLUT.
+//	Each engine and its reference are timed blitting whole frames.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "i_video.c"
+
+#define ITERATIONS 500
+#define FRAMES     2000
+
+// LCD layers; i_video.c keeps their addresses in 32 bits
+
+#define LAYER_SIZE (GFX_MAX_WIDTH * GFX_MAX_HEIGHT * 2)
+
+static byte *layers;
+
+uint32_t lcd_frame_buffer;
+lcd_layers_t lcd_layer;
+bool lcd_vsync;
+uint8_t lcd_frame_buffers = 2;
+uint64_t lcd_flip_wait_cycles;
+uint32_t lcd_flip_waits;
+touch_state_t touch_state;
+const uint8_t img_keys[25608];
+int dirtybox[4];
+const byte gammatable[5][256];
+uint8_t debug_char;
+
+void lcd_refresh (void) { }
+void lcd_flip (void) { }
+void lcd_triple_buffer_init (void) { }
+void lcd_indexed_init (uint16_t x) { }
+void lcd_set_clut (const uint32_t* clut) { }
+void lcd_set_layer (lcd_layers_t layer) { }
+bool button_read (void) { return false; }
+void touch_main (void) { }
+void gfx_init_img (gfx_image_t* a, uint16_t b, uint16_t c, gfx_pixel_format_t d, uint32_t e) { }
+void gfx_init_img_coord (gfx_coord_t* a, gfx_image_t* b) { }
+void gfx_draw_img (gfx_image_t* a, gfx_coord_t* b) { }
+void D_PostEvent (event_t* ev) { }
+void M_BindVariable (char* name, void* location) { }
+uint32_t lcd_spare_buffer (uint8_t n) { return 0; }
+void M_ClearBox (fixed_t* box) { }
+void* W_CacheLumpName (char* name, int tag) { return NULL; }
+void W_ReleaseLumpName (char* name) { }
+int M_CheckParm (char* check) { return 0; }
+void Z_PrintStats (void) { }
+
+void* Z_Malloc (int size, int tag, void* user)
+{
+    return calloc (1, size);
+}
+
+void Z_Free (void* ptr)
+{
+    free (ptr);
+}
+
+// the host's clock in nanoseconds instead of the DWT cycle counter
+
+unsigned int I_GetCycles (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void SetLayer (int n)
+{
+    lcd_frame_buffer = (uint32_t) (uintptr_t) (layers + n * LAYER_SIZE);
+}
+
+static void RandomScreen (void)
+{
+    int i;
+
+    for (i = 0; i < SCREENWIDTH * SCREENHEIGHT; i++)
+	I_VideoBuffer[i] = rand ();
+}
+
+//
+// Compares Doom's area of layer 0, an RGB565 layer, with layer 1,
+// which is RGB565 too or indexed and seen through the CLUT.
+//
+static boolean LayersDiffer (boolean indexed)
+{
+    uint16_t* ref = (uint16_t*) layers;
+    uint16_t* out = (uint16_t*) (layers + LAYER_SIZE);
+    int i;
+
+    for (i = 0; i < GFX_MAX_WIDTH * GFX_MAX_HEIGHT; i++)
+    {
+	if (i % GFX_MAX_WIDTH >= screen_lcd_x
+	 && ref[i] != (indexed ? I_ClutPixel (layers + LAYER_SIZE, i) : out[i]))
+	{
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+//
+// Layer 1 holds engine's blit of an old frame, in which a random area
+// changes. Blitting only that area with engine must give the same as
+// the reference engine blitting the whole new frame to layer 0.
+//
+static int TestEngine (const char* name, blit_func_t engine,
+		       blit_func_t reference, boolean indexed)
+{
+    int x1, y1, x2, y2;
+    int x, y;
+    int i;
+    int failures = 0;
+
+    for (i = 0; i < ITERATIONS; i++)
+    {
+	x1 = rand () % SCREENWIDTH;
+	x2 = x1 + 1 + rand () % (SCREENWIDTH - x1);
+	y1 = rand () % SCREENHEIGHT;
+	y2 = y1 + 1 + rand () % (SCREENHEIGHT - y1);
+
+	RandomScreen ();
+	SetLayer (1);
+	engine (0, 0, SCREENWIDTH, SCREENHEIGHT);
+
+	for (y = y1; y < y2; y++)
+	    for (x = x1; x < x2; x++)
+		I_VideoBuffer[SCREENOFS(x, y)] = rand ();
+
+	engine (x1, y1, x2, y2);
+	SetLayer (0);
+	reference (0, 0, SCREENWIDTH, SCREENHEIGHT);
+
+	if (LayersDiffer (indexed))
+	{
+	    if (failures++ == 0)
+		printf ("%s: mismatch blitting %i,%i-%i,%i\n", name, x1, y1, x2, y2);
+	}
+    }
+
+    printf ("%s: %i of %i blits differ\n", name, failures, ITERATIONS);
+
+    return failures;
+}
+
+//
+// Prints the time engine and reference take to blit a whole frame to
+// layer 1, which only compares them with each other on the host: the
+// board's cycles come from video_blit_check.
+//
+static void TimeEngine (const char* name, blit_func_t engine,
+			blit_func_t reference)
+{
+    unsigned int start, enginetime, reftime;
+    int i;
+
+    RandomScreen ();
+    SetLayer (1);
+
+    start = I_GetCycles ();
+    for (i = 0; i < FRAMES; i++)
+	engine (0, 0, SCREENWIDTH, SCREENHEIGHT);
+    enginetime = I_GetCycles () - start;
+
+    start = I_GetCycles ();
+    for (i = 0; i < FRAMES; i++)
+	reference (0, 0, SCREENWIDTH, SCREENHEIGHT);
+    reftime = I_GetCycles () - start;
+
+    printf ("%s: %u ns/frame, reference: %u ns/frame\n",
+	    name, enginetime / FRAMES, reftime / FRAMES);
+}
+
+// The palette in all forms, as I_SetPalette sets them, and as PLAYPAL
+
+static byte playpal[256 * 3];
+
+static void SetPalette (void)
+{
+    int i;
+
+    for (i = 0; i < 256; i++)
+    {
+	clut_palette[i] = (uint32_t) (i * 0x010307 + 0x081028) & 0xFFFFFF;
+	rgb565_palette[i] = GFX_RGB565((clut_palette[i] >> 16) & 0xFF,
+				       (clut_palette[i] >> 8) & 0xFF,
+				       clut_palette[i] & 0xFF);
+
+	playpal[i * 3] = clut_palette[i] >> 16;
+	playpal[i * 3 + 1] = clut_palette[i] >> 8;
+	playpal[i * 3 + 2] = clut_palette[i];
+    }
+}
+
+int main (void)
+{
+    int failures = 0;
+
+    layers = mmap (NULL, 2 * LAYER_SIZE, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+    if (layers == MAP_FAILED)
+    {
+	printf ("blit_test: no memory below 4 GB\n");
+	return 1;
+    }
+
+    I_VideoBuffer = Z_Malloc (SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
+
+    SetPalette ();
+
+    failures += TestEngine ("tiled", I_BlitTiled, I_BlitReference, false);
+    failures += TestEngine ("indexed", I_BlitIndexed, I_BlitReference, true);
+
+    TimeEngine ("tiled", I_BlitTiled, I_BlitReference);
+    TimeEngine ("indexed", I_BlitIndexed, I_BlitReference);
+
+    // aspect ratio correction: the stretched reference looks up blended
+    // indexes in the stretch tables
+
+    stretch_tables = I_GetStretchTables (playpal);
+    screen_lcd_x = 0;
+
+    failures += TestEngine ("stretched", I_BlitStretched, I_BlitStretchReference, false);
+    TimeEngine ("stretched", I_BlitStretched, I_BlitStretchReference);
+
+    video_clut = 1;
+    failures += TestEngine ("stretched indexed", I_BlitStretchedIndexed, I_BlitStretchReference, true);
+    TimeEngine ("stretched indexed", I_BlitStretchedIndexed, I_BlitStretchReference);
+
+    return failures != 0;
+}
@@ -0,0 +1,331 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the wall clipping with the coverage bitmap: random
+//	sequences of solid and two-sided segments must give the same
+//	R_StoreWallRange calls as vanilla's list walk, and R_IsCovered
+//	and opencolumns must agree with vanilla's solidsegs.
+//	R_Subsector must keep vanilla's visplane count once the screen
+//	is covered.
+//
+
+#include <stdlib.h>
+
+#include "r_bsp.c"
+#include "r_arena.c"
+
+#define FRAMES 100000
+
+int viewwidth;
+
+// the rest of the renderer, which clipping does not use
+
+seg_t* segs;
+int numsubsectors;
+subsector_t* subsectors;
+node_t* nodes;
+fixed_t viewx, viewy, viewz;
+angle_t viewangle;
+angle_t clipangle;
+int viewangletox[FINEANGLES/2];
+int rw_angle1;
+int sscount;
+int skyflatnum;
+visplane_t* floorplane;
+visplane_t* ceilingplane;
+
+fixed_t FixedMul (fixed_t a, fixed_t b) { return 0; }
+angle_t R_PointToAngle (fixed_t x, fixed_t y) { return 0; }
+int R_PointOnSide (fixed_t x, fixed_t y, node_t* node) { return 0; }
+void R_AddSprites (sector_t* sec) { }
+
+static int findplanes;
+
+visplane_t* R_FindPlane (fixed_t height, int picnum, int lightlevel)
+{
+    findplanes++;
+    return NULL;
+}
+
+// R_StoreWallRange calls of the tested code (0) and the reference (1)
+
+static char walls[2][20000];
+static int wallslength[2];
+static int which;
+
+void R_StoreWallRange (int start, int stop)
+{
+    wallslength[which] += sprintf (walls[which] + wallslength[which],
+				   "%i-%i;", start, stop);
+}
+
+void* Z_Malloc (int size, int tag, void* user)
+{
+    return malloc (size);
+}
+
+void I_Error (char* error, ...)
+{
+    printf ("I_Error: %s\n", error);
+    exit (1);
+}
+
+//
+// Vanilla's clipping, the reference.
+//
+
+static cliprange_t refsegs[SCREENWIDTH / 2 + 2];
+static cliprange_t* refend;
+
+static void RefClipSolidWallSegment (int first, int last)
+{
+    cliprange_t*	next;
+    cliprange_t*	start;
+
+    start = refsegs;
+    while (start->last < first-1)
+	start++;
+
+    if (first < start->first)
+    {
+	if (last < start->first-1)
+	{
+	    R_StoreWallRange (first, last);
+	    next = refend;
+	    refend++;
+
+	    while (next != start)
+	    {
+		*next = *(next-1);
+		next--;
+	    }
+	    next->first = first;
+	    next->last = last;
+	    return;
+	}
+
+	R_StoreWallRange (first, start->first - 1);
+	start->first = first;
+    }
+
+    if (last <= start->last)
+	return;
+
+    next = start;
+    while (last >= (next+1)->first-1)
+    {
+	R_StoreWallRange (next->last + 1, (next+1)->first - 1);
+	next++;
+
+	if (last <= next->last)
+	{
+	    start->last = next->last;
+	    goto crunch;
+	}
+    }
+
+    R_StoreWallRange (next->last + 1, last);
+    start->last = last;
+
+  crunch:
+    if (next == start)
+	return;
+
+    while (next++ != refend)
+	*++start = *next;
+
+    refend = start+1;
+}
+
+static void RefClipPassWallSegment (int first, int last)
+{
+    cliprange_t*	start;
+
+    start = refsegs;
+    while (start->last < first-1)
+	start++;
+
+    if (first < start->first)
+    {
+	if (last < start->first-1)
+	{
+	    R_StoreWallRange (first, last);
+	    return;
+	}
+
+	R_StoreWallRange (first, start->first - 1);
+    }
+
+    if (last <= start->last)
+	return;
+
+    while (last >= (start+1)->first-1)
+    {
+	R_StoreWallRange (start->last + 1, (start+1)->first - 1);
+	start++;
+
+	if (last <= start->last)
+	    return;
+    }
+
+    R_StoreWallRange (start->last + 1, last);
+}
+
+static void RefClearClipSegs (void)
+{
+    refsegs[0].first = -0x7fffffff;
+    refsegs[0].last = -1;
+    refsegs[1].first = viewwidth;
+    refsegs[1].last = 0x7fffffff;
+    refend = refsegs+2;
+}
+
+// vanilla R_CheckBBox's test for a span hidden behind one post
+
+static boolean RefIsCovered (int first, int last)
+{
+    cliprange_t*	start;
+
+    start = refsegs;
+    while (start->last < last)
+	start++;
+
+    return first >= start->first && last <= start->last;
+}
+
+//
+// With every column covered, R_Subsector has nothing to draw, but with
+// vanilla limits it must still look up the planes, which count towards
+// the visplane overflow.
+//
+static int TestSubsector (void)
+{
+    static sector_t sector;
+    static subsector_t subsector;
+    int failures = 0;
+
+    sector.floorheight = -FRACUNIT;
+    sector.ceilingheight = FRACUNIT;
+    subsector.sector = &sector;
+    subsectors = &subsector;
+    numsubsectors = 1;
+
+    viewwidth = SCREENWIDTH;
+    R_ClearClipSegs ();
+    R_ClipSolidWallSegment (0, viewwidth - 1);
+
+    for (vanilla_render_limits = 0; vanilla_render_limits < 2; vanilla_render_limits++)
+    {
+	findplanes = 0;
+	R_Subsector (0);
+
+	if (findplanes != (vanilla_render_limits ? 2 : 0))
+	{
+	    printf ("subsector: %i planes looked up with vanilla_render_limits %i\n",
+		    findplanes, vanilla_render_limits);
+	    failures++;
+	}
+    }
+
+    vanilla_render_limits = 0;
+
+    return failures;
+}
+
+int main (void)
+{
+    int frame, i, k;
+    int segments, first, last, x;
+    int open;
+    int clipfailures = 0;
+    int coverfailures = 0;
+    int fullframes = 0;
+
+    R_InitArena ();
+
+    for (frame = 0; frame < FRAMES; frame++)
+    {
+	R_ClearArena ();
+	viewwidth = (frame % 3) ? SCREENWIDTH : rand () % 300 + 10;
+
+	R_ClearClipSegs ();
+	RefClearClipSegs ();
+
+	segments = rand () % 80;
+
+	for (i = 0; i < segments; i++)
+	{
+	    // short segments and ones up to the full width
+
+	    first = rand () % viewwidth;
+	    last = first + rand () % ((rand () % 2) ? 8 : viewwidth);
+
+	    if (last >= viewwidth)
+		last = viewwidth - 1;
+
+	    wallslength[0] = wallslength[1] = 0;
+
+	    if (rand () % 3)
+	    {
+		which = 0;
+		R_ClipSolidWallSegment (first, last);
+		which = 1;
+		RefClipSolidWallSegment (first, last);
+	    }
+	    else
+	    {
+		which = 0;
+		R_ClipPassWallSegment (first, last);
+		which = 1;
+		RefClipPassWallSegment (first, last);
+	    }
+
+	    if (wallslength[0] != wallslength[1]
+	     || memcmp (walls[0], walls[1], wallslength[0]))
+	    {
+		if (clipfailures++ == 0)
+		    printf ("clip: %s instead of %s\n", walls[0], walls[1]);
+	    }
+
+	    for (k = 0; k < 4; k++)
+	    {
+		first = rand () % viewwidth;
+		last = first + rand () % 20;
+
+		if (last >= viewwidth)
+		    last = viewwidth - 1;
+
+		if (R_IsCovered (first, last) != RefIsCovered (first, last))
+		    coverfailures++;
+	    }
+
+	    open = 0;
+
+	    for (x = 0; x < viewwidth; x++)
+		open += !RefIsCovered (x, x);
+
+	    if (open != opencolumns)
+		coverfailures++;
+	}
+
+	if (!opencolumns)
+	    fullframes++;
+    }
+
+    printf ("clip: %i clip and %i coverage mismatches in %i frames, "
+	    "%i fully covered\n", clipfailures, coverfailures, FRAMES, fullframes);
+
+    return clipfailures || coverfailures || TestSubsector ();
+}
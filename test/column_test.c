@@ -0,0 +1,217 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the specialized column drawers: R_DrawColumn must
+//	draw exactly what the reference drawer draws, with and without
+//	wrapping at 128 texture rows and with the identity colormap.
+//	The reference and each specialized core are timed on whole columns.
+//
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "r_draw.c"
+
+#define ITERATIONS 200000
+#define COLUMNS    200000
+
+int centery;
+lighttable_t* colormaps;
+int numtextures;
+int* texturewidthmask;
+byte* I_VideoBuffer;
+int firstflat;
+int numflats;
+GameMode_t gamemode;
+
+void* W_CacheLumpNum (int lump, int tag) { return NULL; }
+void* W_CacheLumpName (char* name, int tag) { return NULL; }
+void W_ReleaseLumpNum (int lump) { }
+byte* R_GetColumn (int tex, int col) { return NULL; }
+void V_DrawPatch (int x, int y, patch_t* patch) { }
+void V_MarkRect (int x, int y, int width, int height) { }
+void V_UseBuffer (byte* buffer) { }
+void V_RestoreBuffer (void) { }
+void Z_Free (void* ptr) { free (ptr); }
+
+void* Z_Malloc (int size, int tag, void* user)
+{
+    return malloc (size);
+}
+
+void I_Error (char* error, ...)
+{
+    printf ("I_Error: %s\n", error);
+    exit (1);
+}
+
+// the host's clock in nanoseconds instead of the DWT cycle counter
+
+unsigned int I_GetCycles (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+//
+// Draws random columns with both drawers to screen columns 0 and 1.
+// A third of them use colormap 0, which is the identity map if
+// identity is set.
+//
+static int TestColumns (const char* name, boolean identity)
+{
+    static byte screen[SCREENWIDTH * SCREENHEIGHT];
+    static byte source[1024];
+    static byte maps[NUMCOLORMAPS * 256];
+    int i, y;
+    int failures = 0;
+
+    for (i = 0; i < NUMCOLORMAPS * 256; i++)
+	maps[i] = rand ();
+
+    if (identity)
+	for (i = 0; i < 256; i++)
+	    maps[i] = i;
+
+    for (i = 0; i < 1024; i++)
+	source[i] = rand ();
+
+    colormaps = maps;
+    R_InitDrawers ();
+
+    for (y = 0; y < SCREENHEIGHT; y++)
+	ylookup[y] = screen + y * SCREENYSTEP;
+
+    columnofs[0] = 0;
+    columnofs[1] = SCREENXSTEP;
+
+    for (i = 0; i < ITERATIONS; i++)
+    {
+	centery = rand () % SCREENHEIGHT;
+	dc_source = source + rand () % 512;
+
+	// mostly common scales, some huge steps; offsets around the
+	// 128-row boundary, where the drawers switch to wrapping
+
+	dc_iscale = (rand () % 4) ? rand () % (4 * FRACUNIT) : rand ();
+	dc_texturemid = (rand () % 512 - 256) * FRACUNIT / 2 + rand () % FRACUNIT;
+	dc_colormap = maps + ((rand () % 3 == 0) ? 0 : (rand () % NUMCOLORMAPS) * 256);
+
+	dc_yl = rand () % SCREENHEIGHT;
+	dc_yh = dc_yl + rand () % (SCREENHEIGHT - dc_yl);
+
+	if (rand () % 50 == 0)
+	    dc_yh = dc_yl - 1;
+
+	// first or last row just at either side of a boundary
+
+	if (rand () % 8 == 0)
+	    dc_texturemid = -(dc_yl - centery) * dc_iscale + rand () % 3 - 1;
+	else if (rand () % 8 == 0)
+	    dc_texturemid = (128 << FRACBITS) - (dc_yh - centery) * dc_iscale + rand () % 3 - 1;
+
+	memset (screen, 0, sizeof (screen));
+
+	dc_x = 0;
+	R_DrawColumnReference ();
+	dc_x = 1;
+	R_DrawColumn ();
+
+	for (y = 0; y < SCREENHEIGHT; y++)
+	{
+	    if (ylookup[y][0] != ylookup[y][SCREENXSTEP])
+	    {
+		if (failures++ == 0)
+		    printf ("%s: mismatch drawing %i to %i, iscale %x, texturemid %x\n",
+			    name, dc_yl, dc_yh, dc_iscale, dc_texturemid);
+		break;
+	    }
+	}
+    }
+
+    printf ("%s: %i of %i columns differ\n", name, failures, ITERATIONS);
+
+    return failures;
+}
+
+//
+// Prints the time the reference drawer and R_DrawColumn take for a
+// column of the full view height, which only compares them with each
+// other on the host: the board's cycles come from draw_column_check.
+// iscale picks the core: half a row per pixel stays within the first
+// 128 texture rows, a whole row per pixel wraps.
+//
+static void TimeColumns (const char* name, fixed_t iscale, boolean identity)
+{
+    static byte screen[SCREENWIDTH * SCREENHEIGHT];
+    static byte source[256];
+    static byte maps[NUMCOLORMAPS * 256];
+    unsigned int start, reftime, time;
+    int i, y;
+
+    for (i = 0; i < 256; i++)
+    {
+	source[i] = rand ();
+	maps[i] = identity ? i : rand ();
+    }
+
+    colormaps = maps;
+    R_InitDrawers ();
+
+    for (y = 0; y < SCREENHEIGHT; y++)
+	ylookup[y] = screen + y * SCREENYSTEP;
+
+    columnofs[0] = 0;
+
+    centery = 0;
+    dc_x = 0;
+    dc_yl = 0;
+    dc_yh = SCREENHEIGHT - 1;
+    dc_iscale = iscale;
+    dc_texturemid = 0;
+    dc_source = source;
+    dc_colormap = maps;
+
+    start = I_GetCycles ();
+    for (i = 0; i < COLUMNS; i++)
+	R_DrawColumnReference ();
+    reftime = I_GetCycles () - start;
+
+    start = I_GetCycles ();
+    for (i = 0; i < COLUMNS; i++)
+	R_DrawColumn ();
+    time = I_GetCycles () - start;
+
+    printf ("%s: %u ns/column, reference: %u ns/column\n",
+	    name, time / COLUMNS, reftime / COLUMNS);
+}
+
+int main (void)
+{
+    int failures = 0;
+
+    failures += TestColumns ("columns", false);
+    failures += TestColumns ("identity columns", true);
+
+    TimeColumns ("core", FRACUNIT / 2, false);
+    TimeColumns ("wrapping core", FRACUNIT, false);
+    TimeColumns ("identity core", FRACUNIT / 2, true);
+    TimeColumns ("wrapping identity core", FRACUNIT, true);
+
+    return failures != 0;
+}
@@ -0,0 +1,278 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the drawseg index: for random drawsegs and sprites,
+//	R_DrawSprite walking the index must clip the sprite exactly like
+//	the full scan of all drawsegs from ds_p - 1 down to drawsegs, and
+//	draw the same masked seg ranges in the same order.
+//
+
+#include <stdlib.h>
+
+#include "r_things.c"
+
+#define FRAMES		2000
+#define SPRITES		50
+#define MAXSEGS		(MAXDRAWSEGS + 100)
+#define MAXCALLS	(MAXSEGS * SPRITES)
+
+// the rest of the renderer, which R_DrawSprite does not use
+
+int viewwidth, viewheight;
+int detailshift;
+int extralight;
+int validcount;
+boolean modifiedgame;
+int viewangleoffset;
+int firstspritelump, lastspritelump;
+fixed_t projection;
+fixed_t centerxfrac, centeryfrac;
+fixed_t viewx, viewy, viewz;
+fixed_t viewcos, viewsin;
+fixed_t* spritewidth;
+fixed_t* spriteoffset;
+fixed_t* spritetopoffset;
+lighttable_t* colormaps;
+lighttable_t* fixedcolormap;
+lighttable_t* scalelight[LIGHTLEVELS][MAXLIGHTSCALE];
+lumpinfo_t* lumpinfo;
+player_t* viewplayer;
+byte* translationtables;
+lighttable_t* dc_colormap;
+int dc_x, dc_yl, dc_yh;
+fixed_t dc_iscale, dc_texturemid;
+byte* dc_source;
+byte* dc_translation;
+void (*colfunc) (void);
+void (*basecolfunc) (void);
+void (*fuzzcolfunc) (void);
+void (*transcolfunc) (void);
+drawseg_t* drawsegs;
+drawseg_t* ds_p;
+
+fixed_t FixedMul (fixed_t a, fixed_t b) { return 0; }
+fixed_t FixedDiv (fixed_t a, fixed_t b) { return 0; }
+angle_t R_PointToAngle (fixed_t x, fixed_t y) { return 0; }
+int W_GetNumForName (char* name) { return 0; }
+void R_ResetPool (renderpool_t* pool) { }
+boolean R_GrowPool (renderpool_t* pool) { return false; }
+void Z_Free (void* ptr) { free (ptr); }
+
+void* Z_Malloc (int size, int tag, void* user)
+{
+    return malloc (size);
+}
+
+void I_Error (char* error, ...)
+{
+    printf ("I_Error: %s\n", error);
+    exit (1);
+}
+
+// R_ArenaAlloc hands out one buffer, reset every frame
+
+static uint32_t arena[(MAXSEGS / 32 + 1) * (DSINDEXBUCKETS + 1)];
+
+void* R_ArenaAlloc (int size)
+{
+    return arena;
+}
+
+static seg_t curlines[MAXSEGS];
+static vissprite_t things[SPRITES];
+
+// a fixed side of every seg for every sprite
+
+int R_PointOnSegSide (fixed_t x, fixed_t y, seg_t* line)
+{
+    return ((line - curlines) * 2654435761u + x) >> 31;
+}
+
+// what R_DrawSprite did: the masked seg ranges it drew and the
+//  clipping it passed to R_DrawVisSprite
+
+typedef struct
+{
+    int		calls[MAXCALLS][3];
+    int		numcalls;
+    short	clipbot[SPRITES][SCREENWIDTH];
+    short	cliptop[SPRITES][SCREENWIDTH];
+} result_t;
+
+static result_t* result;
+static vissprite_t* drawing;
+
+void R_RenderMaskedSegRange (drawseg_t* ds, int x1, int x2)
+{
+    if (result->numcalls < MAXCALLS)
+    {
+	result->calls[result->numcalls][0] = ds - drawsegs;
+	result->calls[result->numcalls][1] = x1;
+	result->calls[result->numcalls][2] = x2;
+	result->numcalls++;
+    }
+}
+
+// R_DrawVisSprite caches the patch once the clipping is final; the
+//  patch has one column without posts, so nothing is drawn
+
+static byte patch[sizeof(patch_t) + 1] = { 1, 0 };
+
+void* W_CacheLumpNum (int lump, int tag)
+{
+    int x;
+
+    for (x = drawing->x1; x <= drawing->x2; x++)
+    {
+	result->clipbot[drawing - things][x] = mfloorclip[x];
+	result->cliptop[drawing - things][x] = mceilingclip[x];
+    }
+
+    return patch;
+}
+
+static unsigned int seed;
+
+static unsigned int Random (void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+//
+// Random drawsegs like the BSP traversal leaves them: mostly narrow,
+// a few across the screen, some without silhouette or masked texture,
+// clip lists that point into shared openings.
+//
+static void RandomDrawSegs (void)
+{
+    static drawseg_t segsdrawn[MAXSEGS];
+    static short openings[MAXSEGS * 2][SCREENWIDTH];
+    static short maskedcol[SCREENWIDTH];
+    drawseg_t* ds;
+    int count;
+    int i, x;
+
+    count = Random () % 4 ? Random () % 64 : Random () % MAXSEGS;
+
+    drawsegs = segsdrawn;
+    ds_p = drawsegs + count;
+
+    for (i = 0; i < count; i++)
+    {
+	ds = &drawsegs[i];
+
+	ds->curline = &curlines[i];
+	ds->x1 = Random () % SCREENWIDTH;
+
+	if (Random () % 8)
+	    ds->x2 = ds->x1 + Random () % 24;
+	else
+	    ds->x2 = ds->x1 + Random () % (SCREENWIDTH - ds->x1);
+
+	if (ds->x2 >= SCREENWIDTH)
+	    ds->x2 = SCREENWIDTH - 1;
+
+	ds->scale1 = Random () % (4 * FRACUNIT);
+	ds->scale2 = Random () % (4 * FRACUNIT);
+	ds->silhouette = Random () % 4;
+	ds->bsilheight = Random () % (64 * FRACUNIT);
+	ds->tsilheight = Random () % (64 * FRACUNIT);
+	ds->sprbottomclip = openings[i * 2];
+	ds->sprtopclip = openings[i * 2 + 1];
+	ds->maskedtexturecol = Random () % 4 ? NULL : maskedcol;
+
+	for (x = 0; x < SCREENWIDTH; x++)
+	{
+	    openings[i * 2][x] = Random () % SCREENHEIGHT;
+	    openings[i * 2 + 1][x] = Random () % SCREENHEIGHT;
+	}
+    }
+
+    for (i = 0; i < SPRITES; i++)
+    {
+	things[i].x1 = Random () % SCREENWIDTH;
+	things[i].x2 = things[i].x1 + Random () % (SCREENWIDTH - things[i].x1);
+	things[i].scale = Random () % (4 * FRACUNIT);
+	things[i].gx = Random ();
+	things[i].gy = Random ();
+	things[i].gz = Random () % (64 * FRACUNIT);
+	things[i].gzt = things[i].gz + Random () % (64 * FRACUNIT);
+	things[i].colormap = (lighttable_t*) patch;
+	things[i].mobjflags = 0;
+	things[i].xiscale = 0;
+	things[i].startfrac = 0;
+    }
+}
+
+static void DrawSprites (result_t* r)
+{
+    int i;
+
+    result = r;
+    result->numcalls = 0;
+    memset (result->clipbot, 0, sizeof(result->clipbot));
+    memset (result->cliptop, 0, sizeof(result->cliptop));
+
+    for (i = 0; i < SPRITES; i++)
+    {
+	drawing = &things[i];
+	R_DrawSprite (drawing);
+    }
+}
+
+int main (void)
+{
+    static result_t scanned, indexed;
+    int failures = 0;
+    int frame;
+
+    // one column without posts at columnofs[0]
+
+    ((patch_t*) patch)->columnofs[0] = sizeof(patch_t);
+    patch[sizeof(patch_t)] = 0xff;
+
+    viewheight = SCREENHEIGHT;
+    colfunc = basecolfunc;
+
+    for (frame = 0; frame < FRAMES; frame++)
+    {
+	seed = frame * 2654435761u;
+	RandomDrawSegs ();
+
+	// the full scan is what R_DrawSprite does without the index
+
+	dsindex = NULL;
+	DrawSprites (&scanned);
+
+	R_BuildDrawSegIndex ();
+	DrawSprites (&indexed);
+
+	if (indexed.numcalls != scanned.numcalls
+	 || memcmp (indexed.calls, scanned.calls, scanned.numcalls * sizeof(scanned.calls[0]))
+	 || memcmp (indexed.clipbot, scanned.clipbot, sizeof(scanned.clipbot))
+	 || memcmp (indexed.cliptop, scanned.cliptop, sizeof(scanned.cliptop)))
+	{
+	    if (failures++ == 0)
+		printf ("drawseg: frame %i with %i drawsegs differs\n",
+			frame, (int) (ds_p - drawsegs));
+	}
+    }
+
+    printf ("drawseg: %i of %i frames differ from the scan\n",
+	    failures, FRAMES);
+
+    return failures != 0;
+}
@@ -0,0 +1,249 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the intercept heap: random traces with many equal
+//	fracs, reduced maxfrac, traversers that stop early and ones that
+//	start another trace must hand the traverser the same intercepts
+//	in the same order as vanilla's scan, and return the same value.
+//	intercept_check must stop the game when the heap goes wrong.
+//
+
+#include <setjmp.h>
+#include <stdlib.h>
+
+#include "p_maputl.c"
+
+#define TRACES		300000
+#define MAXCALLS	1024
+
+// the rest of the game, which P_TraverseIntercepts does not use
+
+short* blockmaplump;
+short* blockmap;
+int bmapwidth, bmapheight;
+fixed_t bmaporgx, bmaporgy;
+mobj_t** blocklinks;
+line_t* lines;
+int validcount;
+fixed_t bulletslope;
+mapthing_t playerstarts[MAXPLAYERS];
+
+fixed_t FixedMul (fixed_t a, fixed_t b) { return 0; }
+fixed_t FixedDiv (fixed_t a, fixed_t b) { return 0; }
+subsector_t* R_PointInSubsector (fixed_t x, fixed_t y) { return NULL; }
+
+static jmp_buf errorjump;
+static boolean catcherror;
+
+void I_Error (char* error, ...)
+{
+    if (catcherror)
+	longjmp (errorjump, 1);
+
+    printf ("I_Error: %s\n", error);
+    exit (1);
+}
+
+//
+// Vanilla's P_TraverseIntercepts, the reference.
+//
+
+static boolean RefTraverseIntercepts (traverser_t func, fixed_t maxfrac)
+{
+    int			count;
+    fixed_t		dist;
+    intercept_t*	scan;
+    intercept_t*	in;
+
+    count = intercept_p - intercepts;
+
+    in = 0;
+
+    while (count--)
+    {
+	dist = INT_MAX;
+	for (scan = intercepts ; scan<intercept_p ; scan++)
+	{
+	    if (scan->frac < dist)
+	    {
+		dist = scan->frac;
+		in = scan;
+	    }
+	}
+
+	if (dist > maxfrac)
+	    return true;
+
+	if ( !func (in) )
+	    return false;
+
+	in->frac = INT_MAX;
+    }
+
+    return true;
+}
+
+static unsigned int seed;
+
+static unsigned int Random (void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// Fills intercepts[] like P_PathTraverse does: few intercepts or up
+//  to the whole array, a third of them at one of four fracs.
+
+static void FillIntercepts (void)
+{
+    int		count;
+    int		i;
+
+    count = Random () % 4 ? Random () % 20 : Random () % (MAXINTERCEPTS + 1);
+
+    intercept_p = intercepts;
+    interceptgeneration++;
+
+    for (i = 0; i < count; i++)
+    {
+	if (Random () % 3)
+	    intercept_p->frac = Random () % (2 * FRACUNIT);
+	else
+	    intercept_p->frac = (Random () % 4) * (FRACUNIT / 4);
+
+	intercept_p++;
+    }
+}
+
+// traverser calls of a run: intercept index, frac and nesting depth
+
+static int calls[MAXCALLS];
+static int numcalls;
+static int depth;
+static boolean (*traverse) (traverser_t func, fixed_t maxfrac);
+
+static boolean Traverser (intercept_t* in)
+{
+    if (numcalls < MAXCALLS)
+    {
+	calls[numcalls++] = ((in - intercepts) << 20)
+			  | ((in->frac & 0xffff) << 2) | depth;
+    }
+
+    // like a PTR_ function that shoots or uses through the line
+
+    if (depth == 0 && Random () % 40 == 0)
+    {
+	depth++;
+	FillIntercepts ();
+	traverse (Traverser, FRACUNIT);
+	depth--;
+    }
+
+    return Random () % 25 != 0;
+}
+
+static boolean Run (boolean (*func) (traverser_t, fixed_t),
+		    unsigned int traceseed, fixed_t maxfrac)
+{
+    seed = traceseed;
+    FillIntercepts ();
+
+    traverse = func;
+    numcalls = 0;
+
+    return func (Traverser, maxfrac);
+}
+
+//
+// TestCheck
+// intercept_check must accept the heap's choice and stop the game
+//  when another intercept is handed out.
+//
+static int TestCheck (void)
+{
+    int		failures = 0;
+
+    intercepts[0].frac = FRACUNIT;
+    intercepts[1].frac = FRACUNIT / 2;
+    intercepts[2].frac = FRACUNIT / 2;
+    intercept_p = intercepts + 3;
+
+    catcherror = true;
+
+    if (!setjmp (errorjump))
+	P_CheckIntercept (&intercepts[1]);
+    else
+	failures++;
+
+    // the nearer of two equal fracs comes first in intercepts[]
+
+    if (!setjmp (errorjump))
+    {
+	P_CheckIntercept (&intercepts[2]);
+	failures++;
+    }
+
+    if (!setjmp (errorjump))
+    {
+	P_CheckIntercept (&intercepts[0]);
+	failures++;
+    }
+
+    catcherror = false;
+
+    printf ("intercept: %i intercept_check failures\n", failures);
+
+    return failures;
+}
+
+int main (void)
+{
+    static int refcalls[MAXCALLS];
+    int		refnumcalls;
+    boolean	refresult;
+    boolean	result;
+    fixed_t	maxfrac;
+    int		failures = 0;
+    int		t;
+
+    // the heap is checked against the scan as it runs
+
+    intercept_check = 1;
+
+    for (t = 0; t < TRACES; t++)
+    {
+	maxfrac = t % 3 ? FRACUNIT : (fixed_t) ((t * 2654435761u) % FRACUNIT);
+
+	refresult = Run (RefTraverseIntercepts, t * 2654435761u, maxfrac);
+	refnumcalls = numcalls;
+	memcpy (refcalls, calls, numcalls * sizeof (*calls));
+
+	result = Run (P_TraverseIntercepts, t * 2654435761u, maxfrac);
+
+	if (result != refresult || numcalls != refnumcalls
+	 || memcmp (calls, refcalls, numcalls * sizeof (*calls)))
+	{
+	    if (failures++ == 0)
+		printf ("intercept: trace %i differs after %i calls\n",
+			t, numcalls);
+	}
+    }
+
+    printf ("intercept: %i of %i traces differ from the scan\n",
+	    failures, TRACES);
+
+    return failures || TestCheck ();
+}
@@ -0,0 +1,219 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the packed span drawers: R_DrawSpan and R_DrawSpanLow
+//	must draw exactly what the original byte drawers draw, for spans
+//	starting and ending at every offset to a word boundary, and with
+//	random positions and steps. Both are timed on whole view lines.
+//
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "r_draw.c"
+
+#define ITERATIONS 200000
+#define SPANS      200000
+
+int centery;
+lighttable_t* colormaps;
+int numtextures;
+int* texturewidthmask;
+byte* I_VideoBuffer;
+int firstflat;
+int numflats;
+GameMode_t gamemode;
+
+void* W_CacheLumpNum (int lump, int tag) { return NULL; }
+void* W_CacheLumpName (char* name, int tag) { return NULL; }
+void W_ReleaseLumpNum (int lump) { }
+byte* R_GetColumn (int tex, int col) { return NULL; }
+void V_DrawPatch (int x, int y, patch_t* patch) { }
+void V_MarkRect (int x, int y, int width, int height) { }
+void V_UseBuffer (byte* buffer) { }
+void V_RestoreBuffer (void) { }
+void Z_Free (void* ptr) { free (ptr); }
+
+void* Z_Malloc (int size, int tag, void* user)
+{
+    return malloc (size);
+}
+
+void I_Error (char* error, ...)
+{
+    printf ("I_Error: %s\n", error);
+    exit (1);
+}
+
+// the host's clock in nanoseconds instead of the DWT cycle counter
+
+unsigned int I_GetCycles (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static byte screen[SCREENWIDTH * SCREENHEIGHT];
+static byte flat[64 * 64];
+static byte maps[NUMCOLORMAPS * 256];
+
+static void SetupScreen (void)
+{
+    int i;
+
+    for (i = 0; i < 64 * 64; i++)
+	flat[i] = rand ();
+
+    for (i = 0; i < NUMCOLORMAPS * 256; i++)
+	maps[i] = rand ();
+
+    for (i = 0; i < SCREENHEIGHT; i++)
+	ylookup[i] = screen + i * SCREENYSTEP;
+
+    for (i = 0; i < SCREENWIDTH; i++)
+	columnofs[i] = i * SCREENXSTEP;
+
+    ds_source = flat;
+}
+
+//
+// Draws random spans with the reference drawer to screen line 0 and
+// the packed one to line 1. In low detail ds_x1 and ds_x2 are in
+// texels, each two pixels wide.
+//
+static int TestSpans (const char* name, boolean low)
+{
+    int width;
+    int x1, x2;
+    int i, x;
+    int failures = 0;
+
+    width = low ? SCREENWIDTH / 2 : SCREENWIDTH;
+
+    for (i = 0; i < ITERATIONS; i++)
+    {
+	// mostly short spans, where head and tail meet
+
+	x1 = rand () % width;
+
+	if (rand () % 3 == 0)
+	    x2 = x1 + rand () % 8;
+	else
+	    x2 = x1 + rand () % (width - x1);
+
+	if (x2 >= width)
+	    x2 = width - 1;
+
+	ds_xfrac = (fixed_t) ((unsigned int) rand () << 16 ^ rand ());
+	ds_yfrac = (fixed_t) ((unsigned int) rand () << 16 ^ rand ());
+	ds_xstep = rand () % (8 * FRACUNIT) - 4 * FRACUNIT;
+	ds_ystep = rand () % (8 * FRACUNIT) - 4 * FRACUNIT;
+	ds_colormap = maps + (rand () % NUMCOLORMAPS) * 256;
+
+	memset (screen, 0, sizeof (screen));
+
+	ds_x1 = x1;
+	ds_x2 = x2;
+	ds_y = 0;
+
+	if (low)
+	    R_DrawSpanLowReference ();
+	else
+	    R_DrawSpanReference ();
+
+	ds_y = 1;
+
+	if (low)
+	    R_DrawSpanLow ();
+	else
+	    R_DrawSpan ();
+
+	for (x = 0; x < SCREENWIDTH; x++)
+	{
+	    if (ylookup[0][columnofs[x]] != ylookup[1][columnofs[x]])
+	    {
+		if (failures++ == 0)
+		    printf ("%s: mismatch drawing %i to %i, step %x,%x\n",
+			    name, x1, x2, ds_xstep, ds_ystep);
+		break;
+	    }
+	}
+    }
+
+    printf ("%s: %i of %i spans differ\n", name, failures, ITERATIONS);
+
+    return failures;
+}
+
+//
+// Prints the time the reference drawer and the packed one take for a
+// span of the full view width, which only compares them with each
+// other on the host: the board's cycles come from draw_span_check.
+//
+static void TimeSpans (const char* name, boolean low)
+{
+    unsigned int start, reftime, time;
+    int i;
+
+    ds_x1 = 0;
+    ds_x2 = (low ? SCREENWIDTH / 2 : SCREENWIDTH) - 1;
+    ds_y = 0;
+    ds_xfrac = 0x123456;
+    ds_yfrac = 0x654321;
+    ds_xstep = FRACUNIT / 3;
+    ds_ystep = -FRACUNIT / 7;
+    ds_colormap = maps;
+
+    start = I_GetCycles ();
+    for (i = 0; i < SPANS; i++)
+    {
+	if (low)
+	    R_DrawSpanLowReference ();
+	else
+	    R_DrawSpanReference ();
+    }
+    reftime = I_GetCycles () - start;
+
+    start = I_GetCycles ();
+    for (i = 0; i < SPANS; i++)
+    {
+	if (low)
+	    R_DrawSpanLow ();
+	else
+	    R_DrawSpan ();
+    }
+    time = I_GetCycles () - start;
+
+    printf ("%s: %u ns/span, reference: %u ns/span\n",
+	    name, time / SPANS, reftime / SPANS);
+}
+
+int main (void)
+{
+    int failures = 0;
+
+    SetupScreen ();
+
+    failures += TestSpans ("spans", false);
+    failures += TestSpans ("low detail spans", true);
+
+    TimeSpans ("spans", false);
+    TimeSpans ("low detail spans", true);
+
+    return failures != 0;
+}
@@ -0,0 +1,118 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host test of the lump rereads in the zone stats: only a lump
+//	the zone purged counts when it is read again, not one freed by
+//	Z_FreeTags or Z_Free, and only once.
+//
+
+#include <stdarg.h>
+
+#include "w_wad.c"
+#include "z_zone.c"
+#include "z_slab.c"
+#include "z_stats.c"
+
+#define LUMPS		10
+#define LUMPSIZE	200000		// five fit in the zone
+
+static byte zonemem[1 << 20];
+
+byte* I_ZoneBase (int* size)
+{
+    *size = sizeof(zonemem);
+    return zonemem;
+}
+
+// the rest of the game, which the lump cache does not use
+
+int I_GetTimeMS (void) { return 0; }
+void I_BeginRead (void) { }
+void I_EndRead (void) { }
+void M_ExtractFileBase (char* path, char* dest) { }
+char* D_GameMissionString (GameMission_t mission) { return ""; }
+char* D_SuggestGameName (GameMission_t mission, GameMode_t mode) { return ""; }
+wad_file_t* W_OpenFile (char* path) { return NULL; }
+
+size_t W_Read (wad_file_t* wad, unsigned int offset,
+	       void* buffer, size_t buffer_len)
+{
+    return buffer_len;
+}
+
+void I_Error (char* error, ...)
+{
+    printf ("I_Error: %s\n", error);
+    exit (1);
+}
+
+static int failures;
+
+static void Expect (char* what, int rereads)
+{
+    if (zonestats.rereads != rereads)
+    {
+	printf ("wad: %s: %u rereads instead of %i\n",
+		what, zonestats.rereads, rereads);
+	failures++;
+    }
+}
+
+int main (void)
+{
+    static wad_file_t	wad;
+    int			i;
+
+    Z_Init ();
+    ExtendLumpInfo (LUMPS);
+
+    for (i = 0; i < LUMPS; i++)
+    {
+	lumpinfo[i].wad_file = &wad;
+	lumpinfo[i].size = LUMPSIZE;
+    }
+
+    W_CacheLumpNum (0, PU_CACHE);
+    W_CacheLumpNum (1, PU_LEVEL);
+    Z_FreeTags (PU_LEVEL, PU_PURGELEVEL - 1);
+    W_CacheLumpNum (1, PU_CACHE);
+    Expect ("after Z_FreeTags", 0);
+
+    Z_Free (lumpinfo[1].cache);
+    W_CacheLumpNum (1, PU_CACHE);
+    Expect ("after Z_Free", 0);
+
+    // the rest throw out the oldest lumps
+
+    for (i = 2; i < LUMPS; i++)
+	W_CacheLumpNum (i, PU_CACHE);
+
+    if (lumpinfo[0].cache != NULL || zonestats.purges == 0)
+    {
+	printf ("wad: lump 0 was not purged\n");
+	failures++;
+    }
+
+    W_CacheLumpNum (0, PU_CACHE);
+    Expect ("after a purge", 1);
+
+    W_CacheLumpNum (0, PU_CACHE);
+    Expect ("in the cache", 1);
+
+    printf ("wad: %i reread failures, %u purges\n",
+	    failures, zonestats.purges);
+
+    return failures;
+}
@@ -0,0 +1,687 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Host stress test of the zone, replaying the operations that
+//	zone_trace prints. Given a debug UART log of a game played with
+//	zone_trace set, it replays that:
+//	 zone_test log.txt [MiB]	the first-fit zone, z_zone.c
+//	 segfit_test log.txt [MiB]	the segregated-fit zone, z_segfit.c
+//	The zone has the size printed in the log, or the size given.
+//	Without a log it plays a made-up workload of static data,
+//	levels, slab pools and lumps cached and purged, and replays the
+//	trace of that, which must purge exactly the same lumps.
+//	Every block is filled with a pattern that is checked while it
+//	lives, and the heap and the stats are checked as it goes.
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef ZONEFILE
+#define ZONEFILE "z_zone.c"
+#endif
+
+#include ZONEFILE
+#include "z_slab.c"
+#include "z_stats.c"
+
+#define DEFAULTZONE	(6 * 1024 * 1024)	// DEFAULT_RAM of i_system.c
+#define WORKLOADZONE	(10 * 1024 * 1024)
+
+#define MAXBLOCKS	(1 << 18)
+#define HASHSIZE	(1 << 20)
+#define CHECKOPS	10000		// ops between full checks
+
+static byte* zonemem;
+static int zonesize;
+
+byte* I_ZoneBase (int* size)
+{
+    *size = zonesize;
+    return zonemem;
+}
+
+int I_GetTimeMS (void)
+{
+    return 0;
+}
+
+void I_Error (char* error, ...)
+{
+    va_list	args;
+
+    va_start (args, error);
+    vprintf (error, args);
+    va_end (args);
+    printf ("\n");
+    exit (1);
+}
+
+static unsigned int seed = 1;
+
+static unsigned int Random (void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+//
+// Blocks of the traced zone, and their copies in the replayed one.
+//  Blocks with a user are found by it as well, so that a lump read
+//  again after a purge is the same block.
+//
+typedef struct
+{
+    void*	ptr;		// in the replayed zone, its user if any
+    void*	traced;		// in the traced zone
+    void*	user;		// in the traced zone, or NULL
+    int		size;
+    int		tag;
+    boolean	live;		// in the traced zone
+    boolean	purged;		// by the traced zone
+    byte	pattern;
+
+} block_t;
+
+static block_t blocks[MAXBLOCKS];
+static int numblocks;
+static int freeblocks[MAXBLOCKS];
+static int numfreeblocks;
+
+typedef struct
+{
+    void*	key;
+    int		block;
+
+} hashentry_t;
+
+static hashentry_t byaddress[HASHSIZE];
+static hashentry_t byuser[HASHSIZE];
+static int hashentries;
+
+static int ops;
+static int skipped;		// ops on blocks allocated before the trace
+static int tracedrereads;
+static int replayrereads;
+static double worstmalloc;
+
+static hashentry_t* Lookup (hashentry_t* table, void* key)
+{
+    unsigned int	i;
+
+    i = (unsigned int) (((uint64_t) (uintptr_t) key * 0x9e3779b97f4a7c15ull)
+			>> 44) & (HASHSIZE - 1);
+
+    while (table[i].key != NULL && table[i].key != key)
+	i = (i + 1) & (HASHSIZE - 1);
+
+    if (table[i].key == NULL)
+    {
+	if (++hashentries > HASHSIZE / 2)
+	    I_Error ("too many addresses in the trace");
+
+	table[i].key = key;
+	table[i].block = -1;
+    }
+
+    return &table[i];
+}
+
+static block_t* Traced (void* traced)
+{
+    block_t*	block;
+    int		i;
+
+    i = Lookup (byaddress, traced)->block;
+
+    if (i < 0)
+	return NULL;
+
+    block = &blocks[i];
+
+    if (!block->live || block->traced != traced)
+	return NULL;
+
+    return block;
+}
+
+static block_t* NewBlock (void)
+{
+    block_t*	block;
+
+    if (numfreeblocks > 0)
+	block = &blocks[freeblocks[--numfreeblocks]];
+    else if (numblocks < MAXBLOCKS)
+	block = &blocks[numblocks++];
+    else
+	I_Error ("too many blocks in the trace");
+
+    memset (block, 0, sizeof(*block));
+
+    return block;
+}
+
+// blocks without a user are not found again once they are gone
+
+static void ForgetBlock (block_t* block)
+{
+    block->live = false;
+
+    if (block->user == NULL)
+    {
+	block->ptr = NULL;
+	freeblocks[numfreeblocks++] = block - blocks;
+    }
+}
+
+static void Fill (block_t* block)
+{
+    byte*	data;
+    int		i;
+
+    data = block->ptr;
+    block->pattern = Random ();
+
+    for (i = 0; i < block->size; i++)
+	data[i] = block->pattern + i * 7;
+}
+
+static void Check (block_t* block, boolean whole)
+{
+    byte*	data;
+    int		i;
+
+    data = block->ptr;
+
+    for (i = 0; i < block->size; i++)
+    {
+	if (data[i] != (byte) (block->pattern + i * 7))
+	    I_Error ("block %p of %i bytes overwritten at %i",
+		     data, block->size, i);
+
+	// the ends, unless it is a full check
+	if (!whole && i == 15 && block->size > 32)
+	    i = block->size - 17;
+    }
+}
+
+static double Now (void)
+{
+    struct timespec	t;
+
+    clock_gettime (CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void Allocate (block_t* block)
+{
+    double	start;
+
+    start = Now ();
+
+    if (block->user)
+	Z_Malloc (block->size, block->tag, &block->ptr);
+    else
+	block->ptr = Z_Malloc (block->size, block->tag, NULL);
+
+    start = Now () - start;
+
+    if (start > worstmalloc)
+	worstmalloc = start;
+
+    Fill (block);
+}
+
+//
+// CheckStats
+// The counts by tag must match a walk of the zone.
+//
+static void CheckStats (void)
+{
+    int		bytes[PU_NUM_TAGS];
+    int		count[PU_NUM_TAGS];
+    int		held;
+    int		tag;
+    memblock_t*	block;
+
+    memset (bytes, 0, sizeof(bytes));
+    memset (count, 0, sizeof(count));
+
+#ifdef NEXTBLOCK
+    for (block = mainzone->first;
+	 block != mainzone->last;
+	 block = NEXTBLOCK (block))
+#else
+    for (block = mainzone->blocklist.next;
+	 block != &mainzone->blocklist;
+	 block = block->next)
+#endif
+    {
+	bytes[block->tag] += block->size;
+	count[block->tag]++;
+    }
+
+    Z_UpdateStats ();
+
+    held = 0;
+
+    for (tag = PU_STATIC; tag < PU_NUM_TAGS; tag++)
+    {
+	if (bytes[tag] != zonestats.bytes[tag]
+	 || count[tag] != zonestats.blocks[tag])
+	{
+	    I_Error ("tag %i: %i bytes in %i blocks, stats say %i in %i",
+		     tag, bytes[tag], count[tag],
+		     zonestats.bytes[tag], zonestats.blocks[tag]);
+	}
+
+	if (HELD (tag))
+	    held += bytes[tag];
+    }
+
+    if (held != zonestats.held)
+	I_Error ("%i bytes held, stats say %i", held, zonestats.held);
+}
+
+static void CheckAll (void)
+{
+    int		i;
+
+    for (i = 0; i < numblocks; i++)
+    {
+	if (blocks[i].ptr)
+	    Check (&blocks[i], true);
+    }
+
+    Z_CheckHeap ();
+    CheckStats ();
+}
+
+//
+// ReplayOp
+// Does one line of a trace, see Z_Trace.
+//
+static void ReplayOp (char op, char* args)
+{
+    block_t*	block;
+    void*	traced;
+    void*	user;
+    int		size, tag, lowtag, hightag;
+    int		i;
+
+    traced = NULL;
+
+    switch (op)
+    {
+      case 'm':
+	if (sscanf (args, "%p %i %i %p", &traced, &size, &tag, &user) != 4)
+	    return;
+
+	if (user)
+	{
+	    i = Lookup (byuser, user)->block;
+	    block = i >= 0 ? &blocks[i] : NULL;
+
+	    if (!block)
+	    {
+		block = NewBlock ();
+		block->user = user;
+		Lookup (byuser, user)->block = block - blocks;
+	    }
+
+	    if (block->purged)
+		tracedrereads++;
+	}
+	else
+	{
+	    block = NewBlock ();
+	}
+
+	if (block->ptr && block->size == size)
+	{
+	    // purged by the traced zone, but still here
+	    Check (block, false);
+	    Z_ChangeTag (block->ptr, tag);
+	}
+	else
+	{
+	    if (block->ptr)
+		Z_Free (block->ptr);
+
+	    if (block->purged)
+	    {
+		replayrereads++;
+		Z_NoteReread (size);
+	    }
+
+	    block->size = size;
+	    block->tag = tag;
+	    Allocate (block);
+	}
+
+	block->traced = traced;
+	block->size = size;
+	block->tag = tag;
+	block->live = true;
+	block->purged = false;
+	Lookup (byaddress, traced)->block = block - blocks;
+	break;
+
+      case 'f':
+	sscanf (args, "%p", &traced);
+
+	// z_zone.c frees the blocks it purges or frees by tag
+	//  through Z_Free as well
+	if (!(block = Traced (traced)))
+	    return;
+
+	Check (block, false);
+	Z_Free (block->ptr);
+	block->ptr = NULL;
+	block->purged = false;
+	ForgetBlock (block);
+	break;
+
+      case 't':
+	if (sscanf (args, "%p %i", &traced, &tag) != 2)
+	    return;
+
+	if (!(block = Traced (traced)))
+	{
+	    skipped++;
+	    return;
+	}
+
+	block->tag = tag;
+
+	if (block->ptr)
+	{
+	    Check (block, false);
+	    Z_ChangeTag (block->ptr, tag);
+	}
+	else
+	{
+	    // purged here but not in the traced zone
+	    replayrereads++;
+	    Z_NoteReread (block->size);
+	    Allocate (block);
+	}
+	break;
+
+      case 'u':
+	if (sscanf (args, "%p %p", &traced, &user) != 2)
+	    return;
+
+	if (!(block = Traced (traced)))
+	{
+	    skipped++;
+	    return;
+	}
+
+	block->user = user;
+	Lookup (byuser, user)->block = block - blocks;
+
+	if (block->ptr)
+	    Z_ChangeUser (block->ptr, &block->ptr);
+	break;
+
+      case 'x':
+	if (sscanf (args, "%i %i", &lowtag, &hightag) != 2)
+	    return;
+
+	Z_FreeTags (lowtag, hightag);
+
+	for (i = 0; i < numblocks; i++)
+	{
+	    block = &blocks[i];
+
+	    if (block->tag < lowtag || block->tag > hightag)
+		continue;
+
+	    // Z_FreeTags cleared the users
+	    if (block->live)
+	    {
+		block->purged = false;
+		ForgetBlock (block);
+	    }
+	    else if (block->user == NULL)
+	    {
+		block->ptr = NULL;
+	    }
+	}
+	break;
+
+      case 'p':
+	sscanf (args, "%p", &traced);
+
+	if (!(block = Traced (traced)))
+	    return;
+
+	block->live = false;
+	block->purged = true;
+	break;
+
+      default:
+	return;
+    }
+
+    if (++ops % CHECKOPS == 0)
+	CheckAll ();
+}
+
+//
+// Replay
+// Replays the "Z " lines of a log. Unless a size is forced, the
+//  zone gets the size the game printed in the log, if it is there.
+//
+static void Replay (FILE* log, int size, boolean forcesize)
+{
+    char	line[256];
+    void*	base;
+    int		started;
+
+    zonesize = size;
+    started = 0;
+
+    while (fgets (line, sizeof(line), log))
+    {
+	if (!started && !forcesize
+	 && sscanf (line, "zone memory: %p, %x", &base, &zonesize) == 2)
+	{
+	    continue;
+	}
+
+	if (line[0] != 'Z' || line[1] != ' ' || line[2] == '\0')
+	    continue;
+
+	if (!started)
+	{
+	    zonemem = malloc (zonesize);
+	    Z_Init ();
+	    started = 1;
+	}
+
+	ReplayOp (line[2], line + 3);
+    }
+
+    if (!started)
+	I_Error ("no zone trace in the log");
+
+    CheckAll ();
+}
+
+//
+// The made-up workload, played with zone_trace on.
+//
+#define LUMPS		3000
+#define LEVELS		10
+#define TICS		10000
+
+static void* lumpcache[LUMPS];
+static int lumpsize[LUMPS];
+
+static int LumpSize (void)
+{
+    int		r;
+
+    r = Random () % 100;
+
+    if (r < 40)
+	return 64 + Random () % 1024;
+    if (r < 80)
+	return 1024 + Random () % 8192;
+    if (r < 97)
+	return 4096 + Random () % 32768;
+
+    return 65536 + Random () % 65536;
+}
+
+// like W_CacheLumpNum followed by W_ReleaseLumpNum
+
+static void UseLump (int lump)
+{
+    if (lumpcache[lump])
+	Z_ChangeTag (lumpcache[lump], PU_STATIC);
+    else
+	Z_Malloc (lumpsize[lump], PU_STATIC, &lumpcache[lump]);
+
+    Z_ChangeTag (lumpcache[lump], PU_CACHE);
+}
+
+static void PlayWorkload (void)
+{
+    static void*	levelblocks[400];
+    static slabpool_t	mobjpool = { "mobj", 160, PU_LEVEL, true };
+    static slabpool_t	specpool = { "spec", 60, PU_LEVSPEC };
+    int			numlevelblocks;
+    int			level;
+    int			tic;
+    int			lump;
+    int			i;
+
+    zonesize = WORKLOADZONE;
+    zonemem = malloc (zonesize);
+    Z_Init ();
+
+    for (i = 0; i < LUMPS; i++)
+	lumpsize[i] = LumpSize ();
+
+    for (i = 0; i < 300; i++)
+	Z_Malloc (16 + Random () % 20000, PU_STATIC, NULL);
+
+    for (level = 0; level < LEVELS; level++)
+    {
+	Z_FreeTags (PU_LEVEL, PU_PURGELEVEL - 1);
+
+	numlevelblocks = 20 + Random () % 30;
+
+	for (i = 0; i < numlevelblocks; i++)
+	    levelblocks[i] = Z_Malloc (16 + Random () % 60000, PU_LEVEL, NULL);
+
+	for (i = 0; i < 2000; i++)
+	    Z_SlabAlloc (Random () & 1 ? &mobjpool : &specpool);
+
+	for (tic = 0; tic < TICS; tic++)
+	{
+	    i = Random () % 100;
+
+	    // most use goes to a few hundred lumps
+	    lump = Random () % 200;
+
+	    if (Random () % 3 == 0)
+		lump = Random () % LUMPS;
+
+	    if (i < 98)
+	    {
+		UseLump (lump);
+	    }
+	    else if (i < 99)
+	    {
+		if (numlevelblocks < 400)
+		{
+		    levelblocks[numlevelblocks++] =
+			Z_Malloc (16 + Random () % 4000, PU_LEVEL, NULL);
+		}
+	    }
+	    else if (numlevelblocks > 0)
+	    {
+		i = Random () % numlevelblocks;
+		Z_Free (levelblocks[i]);
+		levelblocks[i] = levelblocks[--numlevelblocks];
+	    }
+	}
+    }
+
+    free (zonemem);
+}
+
+int main (int argc, char** argv)
+{
+    FILE*	log;
+    int		out;
+
+    if (argc > 1)
+    {
+	log = fopen (argv[1], "r");
+
+	if (!log)
+	    I_Error ("can't open %s", argv[1]);
+
+	if (argc > 2)
+	    Replay (log, atoi (argv[2]) * 1024 * 1024, true);
+	else
+	    Replay (log, DEFAULTZONE, false);
+    }
+    else
+    {
+	// catch the trace printed to stdout
+
+	log = tmpfile ();
+	fflush (stdout);
+	out = dup (1);
+	dup2 (fileno (log), 1);
+
+	zone_trace = 1;
+	PlayWorkload ();
+	zone_trace = 0;
+
+	fflush (stdout);
+	dup2 (out, 1);
+	close (out);
+
+	memset (&zonestats, 0, sizeof(zonestats));
+	rewind (log);
+	Replay (log, WORKLOADZONE, true);
+    }
+
+    fclose (log);
+
+    printf ("%s: %i ops, %i skipped, rereads %i traced, %i replayed, "
+	    "slowest Z_Malloc %.0f us\n", ZONEFILE, ops, skipped,
+	    tracedrereads, replayrereads, worstmalloc / 1000);
+
+    if (argc <= 1 && replayrereads != tracedrereads)
+    {
+	printf ("%s: the replay purged other lumps\n", ZONEFILE);
+	return 1;
+    }
+
+    return 0;
+}